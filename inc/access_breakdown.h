@@ -0,0 +1,100 @@
+#ifndef ACCESS_BREAKDOWN_H
+#define ACCESS_BREAKDOWN_H
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cache.h"
+#include "packed_counters.h"
+
+namespace champsim
+{
+/*
+ * Hits, misses, fills, evictions and dead evictions by core and access type
+ *
+ * Each line remembers the (core, type) of the access that filled it and whether it has been reused since, packed into one
+ * 16-bit counter, so an eviction is charged to the core and type that brought the victim in. A dead eviction is one whose
+ * victim was never hit by anything but a writeback. Row 0 of the matrix absorbs evictions of empty ways, which keeps
+ * update() free of branches apart from the bypass check. The matrix is reported at the end of the run and, as deltas,
+ * every REPORT_INTERVAL accesses.
+ */
+class access_breakdown
+{
+public:
+  static constexpr uint64_t REPORT_INTERVAL = 1 << 24; // accesses between interval reports
+
+private:
+  static constexpr std::size_t NUM_TYPES = static_cast<std::size_t>(access_type::NUM_TYPES);
+  static_assert(NUM_TYPES == 5, "name every access type in type_names");
+  static constexpr std::array<const char*, NUM_TYPES> type_names = {"LOAD", "RFO", "PREFETCH", "WRITE", "TRANSLATION"};
+
+  struct counts {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t fills = 0;
+    uint64_t evictions = 0;
+    uint64_t dead_evictions = 0;
+  };
+
+  std::string name;
+  std::size_t num_way;
+  packed_counters<16> lines; // (1 + cpu * NUM_TYPES + type) << 1 | reused; zero for an empty way
+  std::vector<counts> matrix = std::vector<counts>(1 + NUM_CPUS * NUM_TYPES);
+  std::vector<counts> last_report = matrix;
+  uint64_t accesses = 0;
+  uint64_t intervals = 0;
+
+  void print_rows(const std::string& prefix, const std::vector<counts>& since) const
+  {
+    for (std::size_t cpu = 0; cpu < NUM_CPUS; ++cpu) {
+      for (std::size_t t = 0; t < NUM_TYPES; ++t) {
+        const auto& now = matrix[1 + cpu * NUM_TYPES + t];
+        const auto& then = since[1 + cpu * NUM_TYPES + t];
+        if (now.hits == then.hits && now.misses == then.misses && now.evictions == then.evictions)
+          continue;
+        std::cout << prefix << " CPU " << cpu << " " << type_names[t] << " HIT: " << now.hits - then.hits << " MISS: " << now.misses - then.misses;
+        std::cout << " FILL: " << now.fills - then.fills << " EVICT: " << now.evictions - then.evictions;
+        std::cout << " DEAD EVICT: " << now.dead_evictions - then.dead_evictions << std::endl;
+      }
+    }
+  }
+
+public:
+  access_breakdown(std::string name_, std::size_t num_set, std::size_t num_way_) : name(std::move(name_)), num_way(num_way_), lines(num_set, num_way_)
+  {
+    static_assert(2 * (1 + NUM_CPUS * NUM_TYPES) <= packed_counters<16>::maximum);
+  }
+
+  // Called on every hit and fill; way is NUM_WAY for a bypassed fill
+  void update(uint32_t cpu, uint32_t set, uint32_t way, uint32_t type, uint8_t hit)
+  {
+    auto row = 1 + cpu * NUM_TYPES + type;
+    matrix[row].hits += hit;
+    matrix[row].misses += !hit;
+
+    if (way < num_way) {
+      auto line = lines.get(set, way);
+      auto& victim = matrix[line >> 1];
+      victim.evictions += !hit;
+      victim.dead_evictions += !hit & !(line & 1);
+      matrix[row].fills += !hit;
+
+      auto reused = static_cast<unsigned>(access_type{type} != access_type::WRITE);
+      lines.set(set, way, hit ? (line | reused) : static_cast<unsigned>(row << 1));
+    }
+
+    if (++accesses % REPORT_INTERVAL == 0) {
+      print_rows(name + " INTERVAL " + std::to_string(intervals++), last_report);
+      last_report = matrix;
+    }
+  }
+
+  void print() const { print_rows(name, std::vector<counts>(matrix.size())); }
+};
+} // namespace champsim
+
+#endif
@@ -0,0 +1,252 @@
+#ifndef ASYNC_TRACE_READER_H
+#define ASYNC_TRACE_READER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "spsc_ring.h"
+
+namespace champsim
+{
+/*
+ * Pipelined reader for binary traces of fixed-size records, plain or compressed
+ *
+ * A trace ending in .xz, .gz or .zst is decompressed by an external xz, gzip or zstd process, the way ChampSim reads
+ * compressed instruction traces, so decompression runs in parallel with everything else. A reader thread pulls the
+ * (decompressed) stream into batches of BATCH_RECORDS records in an spsc_ring of BATCHES slots, and the consuming thread
+ * takes records from the batch at the head of the ring with next(), which waits only if the ring is empty. A side that
+ * has to wait blocks until the other notifies it; print() reports the throughput of each stage and how often each side
+ * waited on the other.
+ */
+template <typename Record, std::size_t BATCH_RECORDS = 4096, std::size_t BATCHES = 8>
+class async_trace_reader
+{
+  static_assert(std::is_trivially_copyable_v<Record>);
+  using clock = std::chrono::steady_clock;
+
+  struct batch {
+    std::array<Record, BATCH_RECORDS> records;
+    std::size_t count = 0;
+  };
+
+  std::string path;
+  FILE* stream = nullptr;
+  bool piped = false;
+  std::unique_ptr<spsc_ring<batch, BATCHES>> ring = std::make_unique<spsc_ring<batch, BATCHES>>();
+  bool opened = false;
+  std::atomic<bool> done{false};
+  std::atomic<bool> abandoned{false}; // the consumer stopped before the end of the trace
+  std::thread reader;
+
+  // A side about to block sets its flag, and the other side notifies it only then; each pairs its flag with a full fence
+  // so that a wakeup cannot be lost between the last check and the wait.
+  std::mutex mutex;
+  std::condition_variable slot_free;
+  std::condition_variable batch_ready;
+  std::atomic<bool> reader_waiting{false};
+  std::atomic<bool> consumer_waiting{false};
+
+  std::size_t position = 0; // in the consumer's current batch
+
+  // written by the reader thread, read after it has finished
+  uint64_t bytes_read = 0;
+  uint64_t trailing_bytes = 0;
+  clock::duration read_time{};
+  uint64_t producer_waits = 0;
+
+  // consumer side
+  uint64_t records_consumed = 0;
+  uint64_t consumer_waits = 0;
+  clock::time_point started = clock::now();
+  clock::time_point finished{};
+
+  static std::string decompressor(const std::string& path)
+  {
+    auto ends_with = [&path](const std::string& suffix) {
+      return path.size() >= suffix.size() && path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+    if (ends_with(".xz"))
+      return "xz -dc ";
+    if (ends_with(".gz"))
+      return "gzip -dc ";
+    if (ends_with(".zst"))
+      return "zstd -dc ";
+    return {};
+  }
+
+  // Single-quoted for the shell, with each embedded quote closed, escaped and reopened
+  static std::string shell_quote(const std::string& text)
+  {
+    std::string quoted = "'";
+    for (auto c : text) {
+      if (c == '\'')
+        quoted += "'\\''";
+      else
+        quoted += c;
+    }
+    return quoted + "'";
+  }
+
+  static void notify_if(const std::atomic<bool>& waiting, std::mutex& mutex, std::condition_variable& cv)
+  {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiting.load(std::memory_order_relaxed)) {
+      std::lock_guard lock{mutex};
+      cv.notify_one();
+    }
+  }
+
+  void run()
+  {
+    while (!abandoned.load(std::memory_order_acquire)) {
+      batch* slot = ring->producer_slot();
+      if (slot == nullptr) {
+        ++producer_waits;
+        std::unique_lock lock{mutex};
+        reader_waiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        slot_free.wait(lock, [&] { return (slot = ring->producer_slot()) != nullptr || abandoned.load(std::memory_order_acquire); });
+        reader_waiting.store(false, std::memory_order_relaxed);
+        if (slot == nullptr)
+          break;
+      }
+
+      auto start = clock::now();
+      auto bytes = std::fread(slot->records.data(), 1, sizeof(Record) * BATCH_RECORDS, stream);
+      read_time += clock::now() - start;
+
+      bytes_read += bytes;
+      slot->count = bytes / sizeof(Record);
+      trailing_bytes = bytes % sizeof(Record);
+      if (slot->count > 0) {
+        ring->push();
+        notify_if(consumer_waiting, mutex, batch_ready);
+      }
+      if (bytes < sizeof(Record) * BATCH_RECORDS)
+        break;
+    }
+
+    {
+      std::lock_guard lock{mutex};
+      done.store(true, std::memory_order_release);
+    }
+    batch_ready.notify_one();
+  }
+
+  // Stop the reader, even if the consumer gave up before the end of the trace, and close the stream
+  void close()
+  {
+    {
+      std::lock_guard lock{mutex};
+      abandoned.store(true, std::memory_order_release);
+    }
+    slot_free.notify_one();
+    if (reader.joinable())
+      reader.join();
+    if (stream != nullptr)
+      piped ? pclose(stream) : std::fclose(stream);
+    stream = nullptr;
+  }
+
+public:
+  template <typename Header = std::nullptr_t>
+  explicit async_trace_reader(std::string path_, Header* header = nullptr) : path(std::move(path_))
+  {
+    if (auto command = decompressor(path); !command.empty()) {
+      stream = popen((command + shell_quote(path)).c_str(), "r");
+      piped = true;
+    } else {
+      stream = std::fopen(path.c_str(), "rb");
+    }
+    if (stream == nullptr) {
+      done = true;
+      return;
+    }
+
+    if constexpr (!std::is_same_v<Header, std::nullptr_t>) {
+      static_assert(std::is_trivially_copyable_v<Header>);
+      if (header != nullptr && std::fread(header, sizeof(Header), 1, stream) != 1) {
+        done = true;
+        return;
+      }
+    }
+    opened = true;
+    reader = std::thread{&async_trace_reader::run, this};
+  }
+
+  ~async_trace_reader() { close(); }
+
+  async_trace_reader(const async_trace_reader&) = delete;
+  async_trace_reader& operator=(const async_trace_reader&) = delete;
+
+  // False if the trace could not be opened, or its header could not be read
+  bool good() const { return opened; }
+
+  // The next record, or false at the end of the trace
+  bool next(Record& record)
+  {
+    batch* current = ring->consumer_slot();
+    if (current == nullptr) {
+      // every batch is pushed before done is set, so read done first
+      auto ready = [&] {
+        bool finished_reading = done.load(std::memory_order_acquire);
+        current = ring->consumer_slot();
+        return current != nullptr || finished_reading;
+      };
+      if (!ready()) {
+        ++consumer_waits;
+        std::unique_lock lock{mutex};
+        consumer_waiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        batch_ready.wait(lock, ready);
+        consumer_waiting.store(false, std::memory_order_relaxed);
+      }
+      if (current == nullptr) {
+        if (finished == clock::time_point{})
+          finished = clock::now();
+        return false;
+      }
+    }
+
+    record = current->records[position++];
+    ++records_consumed;
+    if (position == current->count) {
+      position = 0;
+      ring->pop();
+      notify_if(reader_waiting, mutex, slot_free);
+    }
+    return true;
+  }
+
+  // Stops the reader; call after next() has returned false, or the counts cover only the records read so far
+  void print(const std::string& name)
+  {
+    close();
+    auto seconds = [](clock::duration d) { return std::chrono::duration<double>(d).count(); };
+    auto total = seconds((finished == clock::time_point{} ? clock::now() : finished) - started);
+    auto mb = static_cast<double>(bytes_read) / (1 << 20);
+
+    std::cout << name << " TRACE " << path << (piped ? " (decompressed)" : "") << " RECORDS: " << records_consumed << " MB: " << mb;
+    if (trailing_bytes > 0)
+      std::cout << " TRAILING BYTES: " << trailing_bytes;
+    std::cout << std::endl;
+    std::cout << name << " READ STAGE MB/S: " << (seconds(read_time) > 0 ? mb / seconds(read_time) : 0.0) << " WAITS ON FULL RING: " << producer_waits << std::endl;
+    std::cout << name << " CONSUMER RECORDS/S: " << (total > 0 ? static_cast<double>(records_consumed) / total : 0.0) << " WAITS ON EMPTY RING: " << consumer_waits
+              << std::endl;
+  }
+};
+} // namespace champsim
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef ASYNC_TRACE_WRITER_H
+#define ASYNC_TRACE_WRITER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace champsim
+{
+/*
+ * Binary trace of fixed-size records, written by a helper thread
+ *
+ * Records are appended to one of BLOCKS blocks of BLOCK_RECORDS records each, used as a ring. Appending touches only the
+ * current block; a full block is handed to the writer thread under a lock, once every BLOCK_RECORDS records. If every
+ * block is waiting to be written, append() waits for the writer rather than dropping records. The file starts with the
+ * given header. close() writes out the partial block and joins the thread; the destructor calls it.
+ */
+template <typename Record, std::size_t BLOCK_RECORDS = 4096, std::size_t BLOCKS = 4>
+class async_trace_writer
+{
+  static_assert(std::is_trivially_copyable_v<Record>);
+
+  std::ofstream out;
+  std::vector<std::vector<Record>> blocks = std::vector<std::vector<Record>>(BLOCKS);
+  std::size_t head = 0; // block being filled, owned by the simulation thread
+  std::size_t tail = 0; // next block to write, owned by the writer thread
+  std::size_t full = 0; // blocks handed over and not yet written
+
+  std::mutex lock;
+  std::condition_variable changed;
+  bool closing = false;
+  std::thread writer;
+
+  void hand_over()
+  {
+    std::unique_lock guard{lock};
+    ++full;
+    changed.notify_all();
+    changed.wait(guard, [this] { return full < BLOCKS; });
+    head = (head + 1) % BLOCKS;
+  }
+
+  void run()
+  {
+    std::unique_lock guard{lock};
+    while (true) {
+      changed.wait(guard, [this] { return full > 0 || closing; });
+      if (full == 0)
+        return;
+
+      auto& block = blocks[tail];
+      guard.unlock();
+      out.write(reinterpret_cast<const char*>(block.data()), static_cast<std::streamsize>(sizeof(Record) * block.size()));
+      block.clear();
+      guard.lock();
+
+      tail = (tail + 1) % BLOCKS;
+      --full;
+      changed.notify_all();
+    }
+  }
+
+public:
+  template <typename Header>
+  async_trace_writer(const std::string& path, const Header& header) : out(path, std::ios::binary | std::ios::trunc)
+  {
+    static_assert(std::is_trivially_copyable_v<Header>);
+    for (auto& block : blocks)
+      block.reserve(BLOCK_RECORDS);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writer = std::thread{&async_trace_writer::run, this};
+  }
+
+  ~async_trace_writer() { close(); }
+
+  async_trace_writer(const async_trace_writer&) = delete;
+  async_trace_writer& operator=(const async_trace_writer&) = delete;
+
+  bool good() const { return static_cast<bool>(out); }
+
+  void append(const Record& record)
+  {
+    auto& block = blocks[head];
+    block.push_back(record); // never reallocates, the capacity was reserved
+    if (block.size() == BLOCK_RECORDS)
+      hand_over();
+  }
+
+  void close()
+  {
+    if (!writer.joinable())
+      return;
+    if (!blocks[head].empty())
+      hand_over();
+
+    {
+      std::lock_guard guard{lock};
+      closing = true;
+      changed.notify_all();
+    }
+    writer.join();
+    out.flush();
+  }
+};
+} // namespace champsim
+
+#endif
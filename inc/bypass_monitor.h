@@ -0,0 +1,78 @@
+#ifndef BYPASS_MONITOR_H
+#define BYPASS_MONITOR_H
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <string>
+
+#include "champsim_constants.h"
+
+namespace champsim
+{
+/*
+ * Bookkeeping for replacement policies that may decline to allocate.
+ *
+ * A policy signals a bypass by returning NUM_WAY from find_victim (the cache must be built with LLC_BYPASS). The monitor counts allocation decisions and
+ * remembers recently bypassed blocks in a small direct-mapped history, so that a later miss to one of them can be reported as a bypass-then-reuse miss and,
+ * if the policy wishes, fed back to its predictor as a misprediction.
+ */
+template <std::size_t HISTORY_SIZE = 4096>
+class bypass_monitor
+{
+  struct history_entry {
+    bool valid = false;
+    uint64_t block = 0;
+    uint64_t ip = 0;
+    uint32_t type = 0;
+  };
+
+  std::array<history_entry, HISTORY_SIZE> history{};
+
+  static std::size_t index(uint64_t block) { return (block ^ (block >> 12)) % HISTORY_SIZE; }
+
+public:
+  // The fill that was bypassed, as the policy's predictor saw it
+  struct bypassed_fill {
+    uint64_t ip = 0;
+    uint32_t type = 0;
+  };
+
+  uint64_t fills = 0;
+  uint64_t bypasses = 0;
+  uint64_t reuse_misses = 0;
+
+  void record_fill() { ++fills; }
+
+  void record_bypass(uint64_t full_addr, uint64_t ip, uint32_t type)
+  {
+    ++bypasses;
+    auto block = full_addr >> LOG2_BLOCK_SIZE;
+    history[index(block)] = {true, block, ip, type};
+  }
+
+  // Returns the ip and access type of the bypassed fill if this miss re-references a recently bypassed block
+  std::optional<bypassed_fill> check_miss(uint64_t full_addr)
+  {
+    auto block = full_addr >> LOG2_BLOCK_SIZE;
+    auto& entry = history[index(block)];
+    if (!entry.valid || entry.block != block)
+      return std::nullopt;
+
+    ++reuse_misses;
+    entry.valid = false;
+    return bypassed_fill{entry.ip, entry.type};
+  }
+
+  void print(const std::string& name) const
+  {
+    auto decisions = fills + bypasses;
+    std::cout << name << " BYPASS: " << bypasses << " FILL: " << fills;
+    std::cout << " BYPASS RATE: " << (decisions > 0 ? static_cast<double>(bypasses) / static_cast<double>(decisions) : 0.0);
+    std::cout << " BYPASS-THEN-REUSE MISS: " << reuse_misses << std::endl;
+  }
+};
+} // namespace champsim
+
+#endif
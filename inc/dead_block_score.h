@@ -0,0 +1,110 @@
+#ifndef DEAD_BLOCK_SCORE_H
+#define DEAD_BLOCK_SCORE_H
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cache.h"
+#include "packed_counters.h"
+
+namespace champsim
+{
+/*
+ * Scoring of dead-block predictions
+ *
+ * A policy calls predict() when it fills a line, with its prediction (dead or alive) and a confidence from 0 to
+ * MAX_CONFIDENCE. The prediction is kept in 16 bits per line: a pending bit, the prediction, the confidence, a PC bucket and
+ * the core. It is resolved as alive on the line's first hit other than a writeback, or as dead when the line is evicted
+ * first. Resolved predictions go into confusion matrices by core, PC bucket and confidence. Fills the policy bypassed are
+ * not scored here; bypass_monitor counts the ones that were wrong.
+ */
+class dead_block_score
+{
+public:
+  static constexpr unsigned MAX_CONFIDENCE = 3;
+  static constexpr std::size_t PC_BUCKETS = 16;
+
+private:
+  static constexpr unsigned PENDING = 1;
+  static constexpr unsigned PREDICTED_DEAD = 2;
+  static constexpr unsigned CONFIDENCE_SHIFT = 2;
+  static constexpr unsigned BUCKET_SHIFT = 4;
+  static constexpr unsigned CPU_SHIFT = 8;
+
+  // [predicted dead][actually dead]
+  using confusion = std::array<std::array<uint64_t, 2>, 2>;
+
+  std::size_t num_way;
+  packed_counters<16> lines;
+  std::vector<confusion> by_cpu = std::vector<confusion>(NUM_CPUS);
+  std::array<confusion, PC_BUCKETS> by_bucket{};
+  std::array<confusion, MAX_CONFIDENCE + 1> by_confidence{};
+
+  static std::size_t pc_bucket(uint64_t ip) { return static_cast<std::size_t>((ip ^ (ip >> 4) ^ (ip >> 8) ^ (ip >> 16)) % PC_BUCKETS); }
+
+  void resolve(uint32_t set, uint32_t way, bool dead)
+  {
+    auto line = lines.get(set, way);
+    if (!(line & PENDING))
+      return;
+
+    bool predicted = line & PREDICTED_DEAD;
+    ++by_cpu[line >> CPU_SHIFT][predicted][dead];
+    ++by_bucket[(line >> BUCKET_SHIFT) % PC_BUCKETS][predicted][dead];
+    ++by_confidence[(line >> CONFIDENCE_SHIFT) & MAX_CONFIDENCE][predicted][dead];
+    lines.set(set, way, 0);
+  }
+
+  static void print_row(const std::string& prefix, const confusion& c)
+  {
+    auto true_dead = c[1][1], false_dead = c[1][0], false_alive = c[0][1], true_alive = c[0][0];
+    auto total = true_dead + false_dead + false_alive + true_alive;
+    if (total == 0)
+      return;
+
+    std::cout << prefix << " TRUE DEAD: " << true_dead << " FALSE DEAD: " << false_dead << " FALSE ALIVE: " << false_alive << " TRUE ALIVE: " << true_alive;
+    std::cout << " ACCURACY: " << static_cast<double>(true_dead + true_alive) / static_cast<double>(total);
+    std::cout << " COVERAGE: " << (true_dead + false_alive > 0 ? static_cast<double>(true_dead) / static_cast<double>(true_dead + false_alive) : 0.0) << std::endl;
+  }
+
+public:
+  dead_block_score(std::size_t num_set, std::size_t num_way_) : num_way(num_way_), lines(num_set, num_way_)
+  {
+    static_assert(NUM_CPUS <= (packed_counters<16>::maximum >> CPU_SHIFT) + 1);
+  }
+
+  // Called on every hit and fill, before predict(); way is NUM_WAY for a bypassed fill
+  void update(uint32_t set, uint32_t way, uint32_t type, uint8_t hit)
+  {
+    if (way >= num_way)
+      return;
+    if (!hit)
+      resolve(set, way, true);
+    else if (access_type{type} != access_type::WRITE)
+      resolve(set, way, false);
+  }
+
+  // The policy's prediction for the line just filled
+  void predict(uint32_t cpu, uint32_t set, uint32_t way, uint64_t ip, bool dead, unsigned confidence)
+  {
+    auto conf = confidence < MAX_CONFIDENCE ? confidence : MAX_CONFIDENCE;
+    lines.set(set, way,
+              PENDING | (dead ? PREDICTED_DEAD : 0) | (conf << CONFIDENCE_SHIFT) | static_cast<unsigned>(pc_bucket(ip) << BUCKET_SHIFT) | (cpu << CPU_SHIFT));
+  }
+
+  void print(const std::string& name) const
+  {
+    for (std::size_t cpu = 0; cpu < NUM_CPUS; ++cpu)
+      print_row(name + " DEAD BLOCK CPU " + std::to_string(cpu), by_cpu[cpu]);
+    for (std::size_t b = 0; b < PC_BUCKETS; ++b)
+      print_row(name + " DEAD BLOCK PC BUCKET " + std::to_string(b), by_bucket[b]);
+    for (std::size_t c = 0; c <= MAX_CONFIDENCE; ++c)
+      print_row(name + " DEAD BLOCK CONFIDENCE " + std::to_string(c), by_confidence[c]);
+  }
+};
+} // namespace champsim
+
+#endif
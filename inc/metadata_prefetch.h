@@ -0,0 +1,33 @@
+#ifndef METADATA_PREFETCH_H
+#define METADATA_PREFETCH_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace champsim
+{
+/*
+ * Host-side prefetch of replacement metadata
+ *
+ * With a large simulated cache, a set's replacement state is rarely resident in the host's own caches, and each access
+ * stalls on it. Each policy's update_batch() prefetches a set's block through the lookahead form of for_each_set_run(),
+ * RUN_LOOKAHEAD runs before it applies them, so that a caller batching its updates (see replacement_batch.h) overlaps
+ * the misses of later sets with the work on earlier ones. A batch of one, as update_replacement_state() passes, gets
+ * nothing from it, and find_victim() reads its set at once, so it does not prefetch. The prefetches are hints only and
+ * never change simulated behaviour; they are compiled in only with METADATA_PREFETCH, and are pure overhead when the
+ * metadata fits in the host's caches.
+ */
+template <typename T>
+void prefetch_range([[maybe_unused]] const T* first, [[maybe_unused]] std::size_t count)
+{
+#ifdef METADATA_PREFETCH
+  constexpr std::uintptr_t line_size = 64;
+  auto line = reinterpret_cast<std::uintptr_t>(first) & ~(line_size - 1);
+  auto end = reinterpret_cast<std::uintptr_t>(first + count);
+  for (; line < end; line += line_size)
+    __builtin_prefetch(reinterpret_cast<const void*>(line), 1, 3); // the policy will write the set's state
+#endif
+}
+} // namespace champsim
+
+#endif
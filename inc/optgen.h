@@ -0,0 +1,71 @@
+#ifndef OPTGEN_H
+#define OPTGEN_H
+
+#include <cstdint>
+#include <vector>
+
+#include "packed_counters.h"
+
+namespace champsim
+{
+/*
+ * OPTgen (Jain and Lin, ISCA 2016): reconstructs Belady's decisions for the accesses to a few sampled sets.
+ *
+ * Time advances by one quantum per access to a sampled set. The occupancy vector counts, for each of the last vector_size
+ * quanta, how many blocks OPT would hold in the set at that time. A block reused at `now` and last touched at `last` would
+ * have hit under OPT iff the set was never full over [last, now); if so, it occupies that interval from then on.
+ *
+ * The occupancy counters are packed eight to a word, so the check and update over an interval touch one word per eight
+ * quanta and opening a new quantum is a single store.
+ */
+class optgen
+{
+  packed_counters<8> occupancy;
+  std::vector<uint64_t> timer;
+  unsigned capacity;
+
+public:
+  uint64_t accesses = 0;
+  uint64_t hits = 0;
+
+  optgen(std::size_t sampled_sets, unsigned capacity_, std::size_t vector_size) : occupancy(sampled_sets, vector_size), timer(sampled_sets), capacity(capacity_) {}
+
+  // Open the quantum for a new access to the sampled set, and return its time
+  uint64_t access(std::size_t sample)
+  {
+    auto now = timer[sample]++;
+    occupancy.set(sample, now % occupancy.size(), 0);
+    return now;
+  }
+
+  // Decide whether OPT would have hit a reuse at `now` of a block last accessed at `last`
+  bool should_cache(std::size_t sample, uint64_t last, uint64_t now)
+  {
+    ++accesses;
+    auto vector_size = occupancy.size();
+    if (now - last >= vector_size)
+      return false;
+
+    auto begin = last % vector_size;
+    auto end = now % vector_size;
+    bool hit;
+    if (begin < end) {
+      hit = !occupancy.any_at_least(sample, begin, end, capacity);
+      if (hit)
+        occupancy.increment_range(sample, begin, end);
+    } else {
+      hit = !occupancy.any_at_least(sample, begin, vector_size, capacity) && !occupancy.any_at_least(sample, 0, end, capacity);
+      if (hit) {
+        occupancy.increment_range(sample, begin, vector_size);
+        occupancy.increment_range(sample, 0, end);
+      }
+    }
+
+    if (hit)
+      ++hits;
+    return hit;
+  }
+};
+} // namespace champsim
+
+#endif
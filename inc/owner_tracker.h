@@ -0,0 +1,110 @@
+#ifndef OWNER_TRACKER_H
+#define OWNER_TRACKER_H
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "champsim_constants.h"
+#include "packed_counters.h"
+
+namespace champsim
+{
+/*
+ * Per-line owner tracking and cross-core interference accounting
+ *
+ * The owner of a line is the core whose miss filled it, kept as a packed 8-bit ID. When core A's fill evicts core B's line,
+ * the evicted block is remembered in a small direct-mapped history; if B then misses on that block again, the miss is
+ * charged to A as an interference miss. A bypassed miss (way == NUM_WAY) evicts nothing but is still checked.
+ */
+class owner_tracker
+{
+public:
+  static constexpr unsigned NO_OWNER = packed_counters<8>::maximum;
+  static constexpr std::size_t HISTORY_SIZE = 1 << 14;
+  static constexpr uint64_t OCCUPANCY_SAMPLE_INTERVAL = 1 << 16; // misses between occupancy samples
+
+private:
+  struct history_entry {
+    uint64_t block = 0;
+    uint8_t victim = NO_OWNER;
+    uint8_t aggressor = NO_OWNER;
+  };
+
+  std::size_t num_set;
+  std::size_t num_way;
+  packed_counters<8> owners;
+  std::vector<history_entry> history = std::vector<history_entry>(HISTORY_SIZE);
+
+  struct core_stats {
+    uint64_t occupancy = 0;
+    uint64_t occupancy_samples = 0;
+    uint64_t fills = 0;
+  };
+  std::vector<core_stats> stats = std::vector<core_stats>(NUM_CPUS);
+  std::vector<uint64_t> evictions = std::vector<uint64_t>(NUM_CPUS * NUM_CPUS);          // [aggressor][victim]
+  std::vector<uint64_t> interference_misses = std::vector<uint64_t>(NUM_CPUS * NUM_CPUS); // [aggressor][victim]
+  uint64_t misses = 0;
+  uint64_t samples = 0;
+
+  static std::size_t history_index(uint64_t block) { return static_cast<std::size_t>((block ^ (block >> 14) ^ (block >> 28)) % HISTORY_SIZE); }
+
+public:
+  owner_tracker(std::size_t num_set_, std::size_t num_way_) : num_set(num_set_), num_way(num_way_), owners(num_set_, num_way_, NO_OWNER)
+  {
+    static_assert(NUM_CPUS < NO_OWNER);
+  }
+
+  unsigned owner(uint32_t set, uint32_t way) const { return owners.get(set, way); }
+
+  // Record a miss by cpu that filled the given way (NUM_WAY if it was bypassed), evicting victim_addr
+  void miss(uint32_t cpu, uint32_t set, uint32_t way, uint64_t full_addr, uint64_t victim_addr)
+  {
+    auto& returning = history[history_index(full_addr >> LOG2_BLOCK_SIZE)];
+    if (returning.victim == cpu && returning.block == full_addr >> LOG2_BLOCK_SIZE) {
+      ++interference_misses[returning.aggressor * NUM_CPUS + returning.victim];
+      returning = {};
+    }
+
+    if (way < num_way) {
+      if (auto previous = owners.get(set, way); previous != NO_OWNER) {
+        --stats[previous].occupancy;
+        if (previous != cpu) {
+          ++evictions[cpu * NUM_CPUS + previous];
+          history[history_index(victim_addr >> LOG2_BLOCK_SIZE)] = {victim_addr >> LOG2_BLOCK_SIZE, static_cast<uint8_t>(previous), static_cast<uint8_t>(cpu)};
+        }
+      }
+
+      owners.set(set, way, cpu);
+      ++stats[cpu].occupancy;
+      ++stats[cpu].fills;
+    }
+
+    if (++misses % OCCUPANCY_SAMPLE_INTERVAL == 0) {
+      for (auto& s : stats)
+        s.occupancy_samples += s.occupancy;
+      ++samples;
+    }
+  }
+
+  void print(const std::string& name) const
+  {
+    auto total_lines = static_cast<double>(num_set * num_way);
+    for (std::size_t cpu = 0; cpu < NUM_CPUS; ++cpu) {
+      const auto& s = stats[cpu];
+      std::cout << name << " OWNER CPU " << cpu << " FILL: " << s.fills << " OCCUPANCY: " << static_cast<double>(s.occupancy) / total_lines;
+      std::cout << " MEAN OCCUPANCY: " << (samples > 0 ? static_cast<double>(s.occupancy_samples) / static_cast<double>(samples) / total_lines : 0.0);
+      std::cout << std::endl;
+      for (std::size_t aggressor = 0; aggressor < NUM_CPUS; ++aggressor) {
+        if (aggressor != cpu) {
+          std::cout << name << " OWNER CPU " << cpu << " EVICTED BY CPU " << aggressor << ": " << evictions[aggressor * NUM_CPUS + cpu];
+          std::cout << " INTERFERENCE MISS: " << interference_misses[aggressor * NUM_CPUS + cpu] << std::endl;
+        }
+      }
+    }
+  }
+};
+} // namespace champsim
+
+#endif
@@ -0,0 +1,331 @@
+#ifndef PACKED_COUNTERS_H
+#define PACKED_COUNTERS_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "metadata_prefetch.h"
+
+namespace champsim
+{
+/*
+ * A table of small unsigned counters, BITS wide, packed into 64-bit words.
+ *
+ * Counters are organized in rows (typically one row per cache set), and every row is padded to a whole number of words so
+ * that row-wide operations work a word at a time (SWAR) and never touch a neighbouring row. Padding lanes are kept at zero.
+ */
+template <unsigned BITS>
+class packed_counters
+{
+  static_assert(BITS > 0 && BITS <= 16);
+
+public:
+  static constexpr unsigned maximum = (1u << BITS) - 1;
+  static constexpr std::size_t lanes_per_word = 64 / BITS;
+
+private:
+  std::size_t row_size;
+  std::size_t words_per_row;
+  std::vector<uint64_t> words;
+  std::vector<uint64_t> low_masks; // bit 0 of every valid lane, for each word position within a row
+
+  static constexpr uint64_t lane_mask = (uint64_t{1} << BITS) - 1;
+
+  static constexpr uint64_t make_low_mask(std::size_t lanes)
+  {
+    uint64_t mask = 0;
+    for (std::size_t i = 0; i < lanes; ++i)
+      mask |= uint64_t{1} << (i * BITS);
+    return mask;
+  }
+
+  // Bit 0 of each lane is set iff any bit of that lane is set
+  static uint64_t fold_or(uint64_t x)
+  {
+    uint64_t y = x;
+    for (unsigned b = 1; b < BITS; ++b)
+      y |= x >> b;
+    return y;
+  }
+
+  // Bit 0 of each lane is set iff every bit of that lane is set
+  static uint64_t fold_and(uint64_t x)
+  {
+    uint64_t y = x;
+    for (unsigned b = 1; b < BITS; ++b)
+      y &= x >> b;
+    return y;
+  }
+
+  // Largest counter among the lanes whose low bit is set in alive (0 if there are none). The value is settled one bit at a
+  // time from the top, keeping only the lanes that match every bit settled so far, so the cost is BITS steps per word.
+  static unsigned lane_max(uint64_t x, uint64_t alive)
+  {
+    unsigned result = 0;
+    for (unsigned b = BITS; b-- > 0 && alive != 0;) {
+      if (auto high = (x >> b) & alive; high != 0) {
+        alive = high;
+        result |= 1u << b;
+      }
+    }
+    return result;
+  }
+
+  // Low mask of the lanes in [begin, end) of word position `word` within a row
+  uint64_t range_mask(std::size_t word, std::size_t begin, std::size_t end) const
+  {
+    auto first = word * lanes_per_word;
+    auto lo = begin > first ? begin - first : 0;
+    auto hi = end - first < lanes_per_word ? end - first : lanes_per_word;
+    return low_masks[word] & make_low_mask(hi) & ~make_low_mask(lo);
+  }
+
+  // Low bit of every lane of word position `word` whose counter is selected by candidates (bit i is counter i)
+  uint64_t lane_select(std::size_t word, uint64_t candidates) const
+  {
+    auto first = word * lanes_per_word;
+    uint64_t lanes = 0;
+    for (auto bits = first < 64 ? candidates >> first : 0; bits != 0; bits &= bits - 1) {
+      auto i = static_cast<std::size_t>(__builtin_ctzll(bits));
+      if (i >= lanes_per_word)
+        break;
+      lanes |= uint64_t{1} << (i * BITS);
+    }
+    return lanes & low_masks[word];
+  }
+
+  uint64_t* row_words(std::size_t row) { return words.data() + row * words_per_row; }
+  const uint64_t* row_words(std::size_t row) const { return words.data() + row * words_per_row; }
+
+public:
+  packed_counters(std::size_t rows, std::size_t row_size_, unsigned initial = 0)
+      : row_size(row_size_), words_per_row((row_size_ + lanes_per_word - 1) / lanes_per_word), words(rows * words_per_row), low_masks(words_per_row)
+  {
+    assert(initial <= maximum);
+    for (std::size_t w = 0; w < words_per_row; ++w) {
+      auto lanes = row_size - w * lanes_per_word;
+      low_masks[w] = make_low_mask(lanes < lanes_per_word ? lanes : lanes_per_word);
+    }
+
+    for (std::size_t i = 0; i < words.size(); ++i)
+      words[i] = low_masks[i % words_per_row] * initial;
+  }
+
+  std::size_t size() const { return row_size; }
+
+  // Bring the row into the host's caches ahead of use
+  void prefetch_row(std::size_t row) const { prefetch_range(row_words(row), words_per_row); }
+
+  unsigned get(std::size_t row, std::size_t i) const
+  {
+    assert(i < row_size);
+    return static_cast<unsigned>((row_words(row)[i / lanes_per_word] >> ((i % lanes_per_word) * BITS)) & lane_mask);
+  }
+
+  void set(std::size_t row, std::size_t i, unsigned value)
+  {
+    assert(i < row_size);
+    assert(value <= maximum);
+    auto& word = row_words(row)[i / lanes_per_word];
+    auto shamt = (i % lanes_per_word) * BITS;
+    word = (word & ~(lane_mask << shamt)) | (uint64_t{value} << shamt);
+  }
+
+  void increment(std::size_t row, std::size_t i)
+  {
+    if (auto v = get(row, i); v < maximum)
+      set(row, i, v + 1);
+  }
+
+  void decrement(std::size_t row, std::size_t i)
+  {
+    if (auto v = get(row, i); v > 0)
+      set(row, i, v - 1);
+  }
+
+  // Index of the first counter in the row equal to value, or size() if there is none
+  std::size_t find(std::size_t row, unsigned value) const
+  {
+    auto data = row_words(row);
+    for (std::size_t w = 0; w < words_per_row; ++w) {
+      auto equal = ~fold_or(data[w] ^ (low_masks[w] * value)) & low_masks[w];
+      if (equal != 0)
+        return w * lanes_per_word + static_cast<std::size_t>(__builtin_ctzll(equal)) / BITS;
+    }
+    return row_size;
+  }
+
+  // As find(), but only among the counters selected by candidates (bit i is counter i). Rows must have at most 64 counters.
+  std::size_t find(std::size_t row, unsigned value, uint64_t candidates) const
+  {
+    assert(row_size <= 64);
+    auto data = row_words(row);
+    for (std::size_t w = 0; w < words_per_row; ++w) {
+      auto equal = ~fold_or(data[w] ^ (low_masks[w] * value)) & lane_select(w, candidates);
+      if (equal != 0)
+        return w * lanes_per_word + static_cast<std::size_t>(__builtin_ctzll(equal)) / BITS;
+    }
+    return row_size;
+  }
+
+  // Bit i is set iff counter i of the row is nonzero. Rows must have at most 64 counters.
+  uint64_t nonzero_mask(std::size_t row) const
+  {
+    assert(row_size <= 64);
+    auto data = row_words(row);
+    uint64_t mask = 0;
+    for (std::size_t w = 0; w < words_per_row; ++w) {
+      for (auto lanes = fold_or(data[w]) & low_masks[w]; lanes != 0; lanes &= lanes - 1)
+        mask |= uint64_t{1} << (w * lanes_per_word + static_cast<std::size_t>(__builtin_ctzll(lanes)) / BITS);
+    }
+    return mask;
+  }
+
+  // The minimum is found as the maximum of the complemented lanes
+  unsigned row_max(std::size_t row) const
+  {
+    auto data = row_words(row);
+    unsigned result = 0;
+    for (std::size_t w = 0; w < words_per_row && result < maximum; ++w)
+      result = std::max(result, lane_max(data[w], low_masks[w]));
+    return result;
+  }
+
+  unsigned row_min(std::size_t row) const
+  {
+    auto data = row_words(row);
+    unsigned result = maximum;
+    for (std::size_t w = 0; w < words_per_row && result > 0; ++w)
+      result = std::min(result, maximum - lane_max(~data[w], low_masks[w]));
+    return result;
+  }
+
+  // Largest and smallest counters among the candidates; 0 and maximum respectively if there are none
+  unsigned row_max(std::size_t row, uint64_t candidates) const
+  {
+    assert(row_size <= 64);
+    auto data = row_words(row);
+    unsigned result = 0;
+    for (std::size_t w = 0; w < words_per_row && result < maximum; ++w)
+      result = std::max(result, lane_max(data[w], lane_select(w, candidates)));
+    return result;
+  }
+
+  unsigned row_min(std::size_t row, uint64_t candidates) const
+  {
+    assert(row_size <= 64);
+    auto data = row_words(row);
+    unsigned result = maximum;
+    for (std::size_t w = 0; w < words_per_row && result > 0; ++w) {
+      if (auto lanes = lane_select(w, candidates); lanes != 0)
+        result = std::min(result, maximum - lane_max(~data[w], lanes));
+    }
+    return result;
+  }
+
+  // Add amount to every counter in the row. The caller guarantees no counter exceeds maximum afterwards.
+  void add_row(std::size_t row, unsigned amount)
+  {
+    auto data = row_words(row);
+    for (std::size_t w = 0; w < words_per_row; ++w)
+      data[w] += low_masks[w] * amount;
+  }
+
+  // Saturating decrement of every counter in the row
+  void decrement_row(std::size_t row)
+  {
+    auto data = row_words(row);
+    for (std::size_t w = 0; w < words_per_row; ++w)
+      data[w] -= fold_or(data[w]) & low_masks[w];
+  }
+
+  // Saturating increment of every counter in [begin, end) of the row
+  void increment_range(std::size_t row, std::size_t begin, std::size_t end)
+  {
+    if (begin >= end)
+      return;
+    auto data = row_words(row);
+    for (std::size_t w = begin / lanes_per_word; w <= (end - 1) / lanes_per_word; ++w)
+      data[w] += ~fold_and(data[w]) & range_mask(w, begin, end);
+  }
+
+  // Whether any counter in [begin, end) of the row is at least threshold
+  bool any_at_least(std::size_t row, std::size_t begin, std::size_t end, unsigned threshold) const
+  {
+    if (begin >= end)
+      return false;
+    if (threshold == 0)
+      return true;
+
+    // Subtract threshold from each lane with its top bit borrowed in: a lane keeps its guard bit iff it was >= threshold.
+    // This needs one spare bit per lane, so fall back to a scalar scan when the lanes are full width.
+    auto data = row_words(row);
+    for (std::size_t w = begin / lanes_per_word; w <= (end - 1) / lanes_per_word; ++w) {
+      auto mask = range_mask(w, begin, end);
+      if (threshold > (maximum >> 1)) {
+        for (std::size_t i = w * lanes_per_word; i < (w + 1) * lanes_per_word && i < end; ++i) {
+          if (i >= begin && get(row, i) >= threshold)
+            return true;
+        }
+        continue;
+      }
+
+      auto guard = mask << (BITS - 1);
+      auto lanes = data[w] & (mask * (maximum >> 1));
+      auto high = data[w] & guard;
+      if (high != 0 || (((lanes | guard) - mask * threshold) & guard) != 0)
+        return true;
+    }
+    return false;
+  }
+
+  // Zero every counter in the row
+  void clear_row(std::size_t row)
+  {
+    auto data = row_words(row);
+    for (std::size_t w = 0; w < words_per_row; ++w)
+      data[w] = 0;
+  }
+};
+
+/*
+ * RRIP victim selection over one row of packed RRPVs: return the first way at the maximum RRPV, ageing the whole row just
+ * enough to create one if there is none. This is equivalent to the repeated increment-and-search loop used by SRRIP.
+ */
+template <unsigned BITS>
+std::size_t rrip_find_victim(packed_counters<BITS>& rrpv, std::size_t set, unsigned max_rrpv = packed_counters<BITS>::maximum)
+{
+  auto victim = rrpv.find(set, max_rrpv);
+  if (victim == rrpv.size()) {
+    rrpv.add_row(set, max_rrpv - rrpv.row_max(set));
+    victim = rrpv.find(set, max_rrpv);
+  }
+
+  assert(victim < rrpv.size());
+  return victim;
+}
+
+// As above, but the victim is chosen among the candidate ways only. The whole row is still aged, saturating at maximum.
+template <unsigned BITS>
+std::size_t rrip_find_victim(packed_counters<BITS>& rrpv, std::size_t set, uint64_t candidates, unsigned max_rrpv = packed_counters<BITS>::maximum)
+{
+  auto victim = rrpv.find(set, max_rrpv, candidates);
+  if (victim == rrpv.size()) {
+    auto amount = max_rrpv - rrpv.row_max(set, candidates);
+    if (rrpv.row_max(set) + amount <= packed_counters<BITS>::maximum) {
+      rrpv.add_row(set, amount);
+    } else {
+      for (unsigned i = 0; i < amount; ++i)
+        rrpv.increment_range(set, 0, rrpv.size());
+    }
+    victim = rrpv.find(set, max_rrpv, candidates);
+  }
+
+  assert(victim < rrpv.size());
+  return victim;
+}
+} // namespace champsim
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef PC_PROFILE_H
+#define PC_PROFILE_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cache.h"
+#include "packed_counters.h"
+
+namespace champsim
+{
+/*
+ * Top-K PCs by misses and dead fills, with a Space-Saving sketch (Metwally et al., ICDT 2005)
+ *
+ * The sketch holds K PCs. A miss by a PC, or the eviction of a line it filled before that line was reused, adds one to
+ * its count; an untracked PC takes over the entry with the smallest count, inheriting that count as its error bound. Any
+ * PC whose true count exceeds 1/K of the total is guaranteed to be held. Hits are counted only for tracked PCs, to give
+ * a reuse ratio. The table is fixed-size and searched linearly, so nothing is allocated after construction.
+ *
+ * The filling PC and a reused bit are kept for every line to detect dead fills. Writebacks carry no useful PC and are
+ * ignored, and a writeback hit does not count as reuse.
+ */
+template <std::size_t K = 32>
+class pc_profile
+{
+  struct entry {
+    uint64_t count = 0; // misses plus dead fills, overestimated by at most error
+    uint64_t error = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t dead_fills = 0;
+  };
+
+  static constexpr unsigned VALID = 1;
+  static constexpr unsigned REUSED = 2;
+
+  std::size_t num_way;
+  std::vector<uint64_t> fill_ip;
+  packed_counters<2> line_state;
+
+  std::array<uint64_t, K> ips{};
+  std::array<entry, K> entries{};
+  std::size_t used = 0;
+  uint64_t total = 0;
+
+  std::size_t find(uint64_t ip) const
+  {
+    auto end = std::next(std::begin(ips), used);
+    return static_cast<std::size_t>(std::distance(std::begin(ips), std::find(std::begin(ips), end, ip)));
+  }
+
+  // The entry for ip, taking over the smallest one if the table is full
+  entry& claim(uint64_t ip)
+  {
+    ++total;
+    if (auto i = find(ip); i < used)
+      return entries[i];
+
+    if (used < K) {
+      ips[used] = ip;
+      return entries[used++];
+    }
+
+    auto smallest = std::min_element(std::begin(entries), std::end(entries), [](const auto& x, const auto& y) { return x.count < y.count; });
+    ips[static_cast<std::size_t>(std::distance(std::begin(entries), smallest))] = ip;
+    *smallest = {smallest->count, smallest->count, 0, 0, 0};
+    return *smallest;
+  }
+
+public:
+  pc_profile(std::size_t num_set, std::size_t num_way_) : num_way(num_way_), fill_ip(num_set * num_way_), line_state(num_set, num_way_) {}
+
+  // Called on every hit and fill; way is NUM_WAY for a bypassed fill
+  void update(uint32_t set, uint32_t way, uint64_t ip, uint32_t type, uint8_t hit)
+  {
+    bool writeback = access_type{type} == access_type::WRITE;
+
+    if (way < num_way && !hit) {
+      if (auto state = line_state.get(set, way); state == VALID) {
+        auto& victim = claim(fill_ip[set * num_way + way]);
+        ++victim.count;
+        ++victim.dead_fills;
+      }
+      fill_ip[set * num_way + way] = ip;
+      line_state.set(set, way, writeback ? 0 : VALID);
+    } else if (way < num_way && !writeback) {
+      line_state.set(set, way, line_state.get(set, way) | REUSED);
+    }
+
+    if (writeback)
+      return;
+
+    if (hit) {
+      if (auto i = find(ip); i < used)
+        ++entries[i].hits;
+    } else {
+      auto& e = claim(ip);
+      ++e.count;
+      ++e.misses;
+    }
+  }
+
+  void print(const std::string& name) const
+  {
+    std::array<std::size_t, K> order{};
+    for (std::size_t i = 0; i < K; ++i)
+      order[i] = i;
+    std::sort(std::begin(order), std::next(std::begin(order), used), [this](auto x, auto y) { return entries[x].count > entries[y].count; });
+
+    std::cout << name << " TOP PC EVENTS: " << total << std::endl;
+    for (std::size_t rank = 0; rank < used; ++rank) {
+      const auto& e = entries[order[rank]];
+      auto accesses = e.hits + e.misses;
+      std::cout << name << " TOP PC " << rank << " IP: 0x" << std::hex << ips[order[rank]] << std::dec << " COUNT: " << e.count << " ERROR: " << e.error;
+      std::cout << " MISS: " << e.misses << " DEAD FILL: " << e.dead_fills << " REUSE RATIO: "
+                << (accesses > 0 ? static_cast<double>(e.hits) / static_cast<double>(accesses) : 0.0) << std::endl;
+    }
+  }
+};
+} // namespace champsim
+
+#endif
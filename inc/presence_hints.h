@@ -0,0 +1,171 @@
+#ifndef PRESENCE_HINTS_H
+#define PRESENCE_HINTS_H
+
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cache.h"
+#include "champsim_constants.h"
+#include "packed_counters.h"
+
+namespace champsim
+{
+class presence_hints;
+
+// Every live presence_hints, by cache name, so that upper-level caches can reach it. Never destroyed, like way_partitions().
+inline std::map<std::string, presence_hints*>& presence_hint_registry()
+{
+  static auto* hints = new std::map<std::string, presence_hints*>;
+  return *hints;
+}
+
+/*
+ * Inclusion-aware victim selection
+ *
+ * In an inclusive hierarchy, evicting a line that an upper-level cache still holds forces a back-invalidation. A policy
+ * passes its victim candidates through filter(), which drops the ways believed to be present above and counts a
+ * back-invalidation when every candidate is. Presence is known in one of two ways, both off until an upper level uses them:
+ *
+ *   - hints: a packed presence bit per line, set by demand fills and hits (which also fill the upper levels), cleared by
+ *     writebacks from above, and set or cleared by explicit hints from the upper levels (presence_hint()).
+ *   - query-based selection (Jaleel et al., MICRO 2010): a callback registered with set_presence_query() is asked about
+ *     each candidate at victim selection time.
+ */
+class presence_hints
+{
+public:
+  using query_type = std::function<bool(uint64_t block_addr)>;
+
+private:
+  enum class mode { off, hints, query };
+
+  std::string name;
+  std::size_t num_set;
+  std::size_t num_way;
+  mode active = mode::off;
+  packed_counters<1> present;
+  std::vector<uint64_t> blocks; // block address held by each line, to resolve hints
+  query_type query;
+
+  uint64_t searches = 0;
+  uint64_t deprioritized = 0;
+  uint64_t back_invalidations = 0;
+  uint64_t hints_applied = 0;
+
+public:
+  presence_hints(std::string name_, std::size_t num_set_, std::size_t num_way_)
+      : name(std::move(name_)), num_set(num_set_), num_way(num_way_), present(num_set_, num_way_), blocks(num_set_ * num_way_, ~uint64_t{0})
+  {
+    presence_hint_registry()[name] = this;
+  }
+
+  ~presence_hints() { presence_hint_registry().erase(name); }
+
+  presence_hints(const presence_hints&) = delete;
+  presence_hints& operator=(const presence_hints&) = delete;
+
+  void set_query(query_type q)
+  {
+    query = std::move(q);
+    active = query ? mode::query : mode::off;
+  }
+
+  // An upper-level cache reports that it now holds, or no longer holds, the block
+  void hint(uint64_t full_addr, bool is_present)
+  {
+    if (active == mode::off)
+      active = mode::hints;
+
+    auto block = full_addr >> LOG2_BLOCK_SIZE;
+    auto set = static_cast<uint32_t>(block % num_set);
+    for (uint32_t way = 0; way < num_way; ++way) {
+      if (blocks[set * num_way + way] == block) {
+        present.set(set, way, is_present);
+        ++hints_applied;
+      }
+    }
+  }
+
+  // Called on every hit and fill
+  void update(uint32_t set, uint32_t way, uint64_t full_addr, uint32_t type, uint8_t hit)
+  {
+    if (way >= num_way)
+      return;
+
+    if (!hit)
+      blocks[set * num_way + way] = full_addr >> LOG2_BLOCK_SIZE;
+
+    // a writeback means the upper level gave the line up; a prefetch fills this level only
+    if (access_type{type} == access_type::WRITE)
+      present.set(set, way, 0);
+    else if (access_type{type} != access_type::PREFETCH)
+      present.set(set, way, 1);
+    else if (!hit)
+      present.set(set, way, 0);
+  }
+
+  // Drop the candidates held above, unless that would leave none
+  uint64_t filter(uint32_t set, uint64_t candidates)
+  {
+    if (active == mode::off)
+      return candidates;
+
+    uint64_t held = 0;
+    if (active == mode::query) {
+      for (auto bits = candidates; bits != 0; bits &= bits - 1) {
+        auto way = static_cast<uint32_t>(__builtin_ctzll(bits));
+        if (query(blocks[set * num_way + way] << LOG2_BLOCK_SIZE))
+          held |= uint64_t{1} << way;
+      }
+    } else {
+      held = present.nonzero_mask(set);
+    }
+
+    ++searches;
+    if ((candidates & held) == 0)
+      return candidates;
+    if ((candidates & ~held) == 0) {
+      ++back_invalidations;
+      return candidates;
+    }
+
+    ++deprioritized;
+    return candidates & ~held;
+  }
+
+  void print() const
+  {
+    if (active == mode::off)
+      return;
+    std::cout << name << " PRESENCE " << (active == mode::query ? "QUERY" : "HINTS") << " SEARCHES: " << searches << " DEPRIORITIZED: " << deprioritized;
+    std::cout << " BACK-INVALIDATIONS: " << back_invalidations << " HINTS: " << hints_applied << std::endl;
+  }
+};
+
+// Report that an upper-level cache holds (or dropped) a block, to the named cache's policy. Returns false if there is none.
+inline bool presence_hint(const std::string& cache_name, uint64_t full_addr, bool is_present)
+{
+  auto found = presence_hint_registry().find(cache_name);
+  if (found == std::end(presence_hint_registry()))
+    return false;
+  found->second->hint(full_addr, is_present);
+  return true;
+}
+
+// Register a query-based selection callback with the named cache's policy; an empty callback turns it off
+inline bool set_presence_query(const std::string& cache_name, presence_hints::query_type query)
+{
+  auto found = presence_hint_registry().find(cache_name);
+  if (found == std::end(presence_hint_registry()))
+    return false;
+  found->second->set_query(std::move(query));
+  return true;
+}
+} // namespace champsim
+
+#endif
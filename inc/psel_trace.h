@@ -0,0 +1,40 @@
+#ifndef PSEL_TRACE_H
+#define PSEL_TRACE_H
+
+#include <cstdint>
+
+namespace champsim
+{
+/*
+ * File format of the DRRIP PSEL trace
+ *
+ * A psel_trace_header, then psel_trace_record entries in the order they were recorded. Each core's PSEL is sampled every
+ * sample_interval of that core's misses, and a switch record is added whenever a leader-set update moves the core's PSEL
+ * across the midpoint. A PSEL above psel_max / 2 means the core's follower sets use BIP.
+ */
+constexpr char PSEL_TRACE_MAGIC[4] = {'P', 'S', 'E', 'L'};
+constexpr uint32_t PSEL_TRACE_VERSION = 1;
+
+struct psel_trace_header {
+  char magic[4];
+  uint32_t version;
+  uint32_t num_cpus;
+  uint32_t psel_max;
+  uint64_t sample_interval;
+};
+
+enum class psel_event : uint8_t { sample = 0, to_bip = 1, to_srrip = 2 };
+
+struct psel_trace_record {
+  uint64_t cycle;
+  uint64_t misses; // misses by this core so far
+  uint16_t cpu;
+  uint16_t psel;
+  psel_event event;
+  uint8_t reserved[3];
+};
+
+static_assert(sizeof(psel_trace_record) == 24);
+} // namespace champsim
+
+#endif
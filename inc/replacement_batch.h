@@ -0,0 +1,134 @@
+#ifndef REPLACEMENT_BATCH_H
+#define REPLACEMENT_BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <string>
+
+namespace champsim
+{
+/*
+ * Batched replacement updates
+ *
+ * A replacement_access carries the arguments of one update_replacement_state() call. Each policy applies a range of them in
+ * order with its own update_batch(), in an anonymous namespace like the rest of its state, exactly as the same sequence
+ * of update_replacement_state() calls would, but looking the cache's replacement state up once per batch and each set's
+ * metadata once per run of consecutive accesses to that set. Callers that can group their accesses by set (keeping each
+ * set's accesses in order) get the longest runs; whether reordering across sets is safe is up to them, since predictors
+ * and statistics shared between sets see the batch's order.
+ *
+ * Every policy implements update_replacement_state() as a batch of one, so the two paths cannot drift apart, and registers
+ * its update_batch() for each cache in replacement_batches(), where update_replacement_batch() reaches it by cache name.
+ */
+struct replacement_access {
+  uint32_t triggering_cpu;
+  uint32_t set;
+  uint32_t way;
+  uint64_t full_addr;
+  uint64_t ip;
+  uint64_t victim_addr;
+  uint32_t type;
+  uint8_t hit;
+};
+
+using replacement_batch_type = std::function<void(const replacement_access* first, const replacement_access* last)>;
+
+// Every cache's batched update, by cache name, registered by its policy's initialize_replacement(). Never destroyed, like way_partitions().
+inline std::map<std::string, replacement_batch_type>& replacement_batches()
+{
+  static auto* batches = new std::map<std::string, replacement_batch_type>;
+  return *batches;
+}
+
+/*
+ * Apply the accesses to the named cache's replacement state, in order. Returns false if no policy registered the cache.
+ *
+ * With REPLACEMENT_BATCH_SEQUENTIAL set to 1 in the environment, each access is applied as a batch of one, exactly as
+ * update_replacement_state() would. A caller checks its batching by running once with it set and once without: the
+ * simulation, and every statistic the policy prints, must come out the same.
+ */
+inline bool update_replacement_batch(const std::string& cache_name, const replacement_access* first, const replacement_access* last)
+{
+  static const bool sequential = [] {
+    const char* value = std::getenv("REPLACEMENT_BATCH_SEQUENTIAL");
+    return value != nullptr && std::strcmp(value, "1") == 0;
+  }();
+
+  auto found = replacement_batches().find(cache_name);
+  if (found == std::end(replacement_batches()))
+    return false;
+
+  if (sequential) {
+    for (; first != last; ++first)
+      found->second(first, first + 1);
+  } else {
+    found->second(first, last);
+  }
+  return true;
+}
+
+// Consecutive accesses to one set
+class set_run
+{
+  const replacement_access* first;
+  const replacement_access* last;
+
+public:
+  set_run(const replacement_access* first_, const replacement_access* last_) : first(first_), last(last_) {}
+
+  uint32_t set() const { return first->set; }
+  const replacement_access* begin() const { return first; }
+  const replacement_access* end() const { return last; }
+};
+
+// The end of the run of accesses to first's set
+inline const replacement_access* set_run_end(const replacement_access* first, const replacement_access* last)
+{
+  auto run_end = first + 1;
+  while (run_end != last && run_end->set == first->set)
+    ++run_end;
+  return run_end;
+}
+
+// Call f with each maximal run of consecutive accesses to one set, in order
+template <typename F>
+void for_each_set_run(const replacement_access* first, const replacement_access* last, F&& f)
+{
+  while (first != last) {
+    auto run_end = set_run_end(first, last);
+    f(set_run{first, run_end});
+    first = run_end;
+  }
+}
+
+// Runs whose sets are prefetched ahead of the one being applied
+constexpr std::size_t RUN_LOOKAHEAD = 4;
+
+// As above, also calling prefetch(set) for the set of the run RUN_LOOKAHEAD runs ahead of each one f is called with, so
+// that its metadata can arrive while the runs before it are applied. In a batch of one the prefetch is of no use.
+template <typename P, typename F>
+void for_each_set_run(const replacement_access* first, const replacement_access* last, P&& prefetch, F&& f)
+{
+  auto ahead = first;
+  for (std::size_t i = 0; i < RUN_LOOKAHEAD && ahead != last; ++i) {
+    prefetch(ahead->set);
+    ahead = set_run_end(ahead, last);
+  }
+
+  while (first != last) {
+    if (ahead != last) {
+      prefetch(ahead->set);
+      ahead = set_run_end(ahead, last);
+    }
+    auto run_end = set_run_end(first, last);
+    f(set_run{first, run_end});
+    first = run_end;
+  }
+}
+} // namespace champsim
+
+#endif
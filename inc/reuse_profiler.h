@@ -0,0 +1,97 @@
+#ifndef REUSE_PROFILER_H
+#define REUSE_PROFILER_H
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cache.h"
+
+namespace champsim
+{
+/*
+ * Sampled reuse-distance histograms, by core and access type
+ *
+ * Every set counts its accesses. One block in 2^SAMPLE_SHIFT, chosen by address hash, is sampled: its set's count at the
+ * last touch is kept in a small direct-mapped table, and on the next touch the number of accesses to the set in between
+ * is its reuse distance. Distances go in log2 buckets (bucket 0 is a distance of zero, bucket b holds [2^(b-1), 2^b)), and
+ * a sampled block with no entry, on first touch or after losing its entry to another block, is counted as cold. Distances
+ * are in set accesses, the unit PDP and Mockingjay use.
+ */
+class reuse_profiler
+{
+public:
+  static constexpr unsigned SAMPLE_SHIFT = 6;
+  static constexpr std::size_t TABLE_SIZE = 1 << 14;
+  static constexpr std::size_t NUM_BUCKETS = 24; // the last bucket also holds every longer distance
+
+private:
+  static constexpr std::size_t NUM_TYPES = static_cast<std::size_t>(access_type::NUM_TYPES);
+  static_assert(NUM_TYPES == 5, "name every access type in type_names");
+  static constexpr std::array<const char*, NUM_TYPES> type_names = {"LOAD", "RFO", "PREFETCH", "WRITE", "TRANSLATION"};
+
+  struct entry {
+    uint64_t block = ~uint64_t{0};
+    uint64_t stamp = 0;
+  };
+
+  struct histogram {
+    std::array<uint64_t, NUM_BUCKETS> buckets{};
+    uint64_t cold = 0;
+  };
+
+  std::vector<uint64_t> set_accesses;
+  std::vector<entry> table = std::vector<entry>(TABLE_SIZE);
+  std::vector<histogram> histograms = std::vector<histogram>(NUM_CPUS * NUM_TYPES);
+
+  static std::size_t bucket(uint64_t distance)
+  {
+    auto b = distance == 0 ? 0 : 64 - static_cast<std::size_t>(__builtin_clzll(distance));
+    return b < NUM_BUCKETS ? b : NUM_BUCKETS - 1;
+  }
+
+public:
+  explicit reuse_profiler(std::size_t num_set) : set_accesses(num_set) {}
+
+  // Called on every access, including bypassed fills
+  void access(uint32_t cpu, uint32_t set, uint64_t full_addr, uint32_t type)
+  {
+    auto now = set_accesses[set]++;
+    auto block = full_addr >> LOG2_BLOCK_SIZE;
+    auto hash = block * 0x9E3779B97F4A7C15ull;
+    if ((hash >> (64 - SAMPLE_SHIFT)) != 0)
+      return;
+
+    auto& e = table[hash % TABLE_SIZE];
+    auto& h = histograms[cpu * NUM_TYPES + type];
+    if (e.block == block)
+      ++h.buckets[bucket(now - e.stamp - 1)];
+    else
+      ++h.cold;
+    e = {block, now};
+  }
+
+  void print(const std::string& name) const
+  {
+    for (std::size_t cpu = 0; cpu < NUM_CPUS; ++cpu) {
+      for (std::size_t t = 0; t < NUM_TYPES; ++t) {
+        const auto& h = histograms[cpu * NUM_TYPES + t];
+        auto last = NUM_BUCKETS;
+        while (last > 0 && h.buckets[last - 1] == 0)
+          --last;
+        if (last == 0 && h.cold == 0)
+          continue;
+
+        std::cout << name << " REUSE DISTANCE CPU " << cpu << " " << type_names[t] << " COLD: " << h.cold << " LOG2 BUCKETS:";
+        for (std::size_t b = 0; b < last; ++b)
+          std::cout << " " << h.buckets[b];
+        std::cout << std::endl;
+      }
+    }
+  }
+};
+} // namespace champsim
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef SAMPLER_SETS_H
+#define SAMPLER_SETS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace champsim
+{
+/*
+ * Randomly selected sampler sets
+ *
+ * The sets a policy's sampler (or its set-dueling leaders) observe, drawn with the linear congruential generator SHiP has
+ * always used, skipping repeats, and kept sorted. At most every set of the cache is selected. index() gives a set's place
+ * among them, for indexing the per-sampler-set state a policy keeps.
+ */
+class sampler_sets
+{
+  std::vector<std::size_t> sets;
+
+public:
+  using const_iterator = std::vector<std::size_t>::const_iterator;
+
+  sampler_sets(std::size_t num_set, std::size_t count)
+  {
+    std::size_t rand_seed = 1103515245 + 12345;
+    for (std::size_t i = 0; i < std::min(count, num_set); i++) {
+      std::size_t val = (rand_seed / 65536) % num_set;
+      auto loc = std::lower_bound(std::begin(sets), std::end(sets), val);
+
+      while (loc != std::end(sets) && *loc == val) {
+        rand_seed = rand_seed * 1103515245 + 12345;
+        val = (rand_seed / 65536) % num_set;
+        loc = std::lower_bound(std::begin(sets), std::end(sets), val);
+      }
+
+      sets.insert(loc, val);
+    }
+  }
+
+  const_iterator begin() const { return std::cbegin(sets); }
+  const_iterator end() const { return std::cend(sets); }
+  std::size_t size() const { return sets.size(); }
+
+  bool contains(std::size_t set) const { return std::binary_search(std::begin(sets), std::end(sets), set); }
+
+  // The set's place among the sampler sets, if it is one
+  std::optional<std::size_t> index(std::size_t set) const
+  {
+    auto loc = std::lower_bound(std::begin(sets), std::end(sets), set);
+    if (loc == std::end(sets) || *loc != set)
+      return std::nullopt;
+    return static_cast<std::size_t>(std::distance(std::begin(sets), loc));
+  }
+};
+} // namespace champsim
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef SET_SAMPLING_H
+#define SET_SAMPLING_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cache.h"
+
+namespace champsim
+{
+/*
+ * Set-sampled replacement statistics
+ *
+ * With SET_SAMPLING=N, a policy models replacement only in about 1/N of the sets, chosen by hashing the set index, plus
+ * every set it includes explicitly: its leader or sampler sets, so that global predictors (DRRIP's PSEL, SHiP's SHCT, the
+ * OPTgen and reuse-distance samplers) train on exactly the sets they would in a full simulation. In every other set the
+ * policy keeps no state and evicts each set's ways in turn (FIFO).
+ *
+ * This is a statistics mode, not a faster simulation: the cache still looks up and fills every set, so only the policy's
+ * own work shrinks. Because the unmodeled sets replace differently, the cache's miss stream, timing and own hit and miss
+ * counts differ from a full run's, and so do the policy's statistics, which see that cache. print() reports the miss
+ * estimate from the modeled sets instead.
+ *
+ * The estimate is stratified: included sets are counted exactly, and the hashed sets stand for every set that is neither
+ * included nor hashed in, with per-set cluster sampling giving the 95% confidence intervals. Writebacks are left out.
+ * Unset, or N of 1, models every set.
+ */
+class set_sampling
+{
+public:
+  static constexpr const char* RATIO_ENV = "SET_SAMPLING";
+
+private:
+  enum : uint8_t { skipped, hashed, included };
+
+  std::size_t ratio = 1;
+  std::size_t num_way;
+  std::vector<uint8_t> kind;
+  std::vector<uint64_t> accesses;
+  std::vector<uint64_t> misses;
+  std::vector<uint32_t> next_victim; // per set, used only in the sets that are not modeled
+
+public:
+  set_sampling(std::size_t num_set, std::size_t num_way_) : num_way(num_way_), kind(num_set, included), accesses(num_set), misses(num_set), next_victim(num_set)
+  {
+    if (const char* value = std::getenv(RATIO_ENV); value != nullptr && std::strtoull(value, nullptr, 0) > 1)
+      ratio = std::strtoull(value, nullptr, 0);
+    if (ratio == 1)
+      return;
+
+    for (std::size_t set = 0; set < num_set; ++set)
+      kind[set] = ((uint64_t{set} * 0x9E3779B97F4A7C15ull) >> 40) % ratio == 0 ? hashed : skipped;
+  }
+
+  // Always model these sets, and count them exactly
+  template <typename Sets>
+  void include(const Sets& sets)
+  {
+    for (auto set : sets)
+      kind[set] = included;
+  }
+
+  bool modeled(uint32_t set) const { return kind[set] != skipped; }
+
+  // The victim in a set that is not modeled: each set's ways in turn
+  uint32_t skipped_victim(uint32_t set)
+  {
+    auto victim = next_victim[set];
+    next_victim[set] = (victim + 1) % static_cast<uint32_t>(num_way);
+    return victim;
+  }
+
+  // Count an access, returning whether the set is modeled
+  bool record(uint32_t set, uint32_t type, uint8_t hit)
+  {
+    if (!modeled(set))
+      return false;
+    if (access_type{type} != access_type::WRITE) {
+      ++accesses[set];
+      misses[set] += !hit;
+    }
+    return true;
+  }
+
+  void print(const std::string& name) const
+  {
+    if (ratio == 1)
+      return;
+
+    uint64_t exact_accesses = 0, exact_misses = 0, sample_accesses = 0, sample_misses = 0;
+    std::size_t population = 0, n = 0, n_included = 0;
+    for (std::size_t set = 0; set < kind.size(); ++set) {
+      if (kind[set] == included) {
+        exact_accesses += accesses[set];
+        exact_misses += misses[set];
+        ++n_included;
+      } else {
+        ++population;
+      }
+      if (kind[set] == hashed) {
+        sample_accesses += accesses[set];
+        sample_misses += misses[set];
+        ++n;
+      }
+    }
+
+    // Expand the hashed sample to the sets it stands for, and take the variance of the per-set misses and of the miss-rate
+    // residuals, with the finite population correction
+    double scale = n > 0 ? static_cast<double>(population) / static_cast<double>(n) : 0.0;
+    double est_accesses = static_cast<double>(exact_accesses) + scale * static_cast<double>(sample_accesses);
+    double est_misses = static_cast<double>(exact_misses) + scale * static_cast<double>(sample_misses);
+    double rate = est_accesses > 0 ? est_misses / est_accesses : 0.0;
+
+    double miss_ci = 0, rate_ci = 0;
+    if (n > 1) {
+      double mean_misses = static_cast<double>(sample_misses) / static_cast<double>(n);
+      double var_misses = 0, var_residual = 0;
+      for (std::size_t set = 0; set < kind.size(); ++set) {
+        if (kind[set] == hashed) {
+          var_misses += std::pow(static_cast<double>(misses[set]) - mean_misses, 2);
+          var_residual += std::pow(static_cast<double>(misses[set]) - rate * static_cast<double>(accesses[set]), 2);
+        }
+      }
+      double fpc = 1.0 - static_cast<double>(n) / static_cast<double>(population);
+      double expansion = static_cast<double>(population) * static_cast<double>(population) * fpc / static_cast<double>(n) / static_cast<double>(n - 1);
+      miss_ci = 1.96 * std::sqrt(expansion * var_misses);
+      rate_ci = est_accesses > 0 ? 1.96 * std::sqrt(expansion * var_residual) / est_accesses : 0.0;
+    }
+
+    std::cout << name << " SET SAMPLING: 1/" << ratio << " HASHED SETS: " << n << " INCLUDED SETS: " << n_included;
+    std::cout << " ESTIMATED ACCESSES: " << est_accesses << " ESTIMATED MISSES: " << est_misses << " +/- " << miss_ci;
+    std::cout << " MISS RATE: " << rate << " +/- " << rate_ci << std::endl;
+  }
+};
+} // namespace champsim
+
+#endif
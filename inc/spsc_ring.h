@@ -0,0 +1,72 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace champsim
+{
+/*
+ * Lock-free single-producer, single-consumer ring of CAPACITY slots
+ *
+ * Slots are filled and drained in place: the producer writes into producer_slot() and publishes it with push(), the
+ * consumer reads consumer_slot() and hands it back with pop(). Either side gets nullptr when the ring is full or empty.
+ * The two indices sit on separate cache lines so the threads do not share one.
+ */
+template <typename T, std::size_t CAPACITY>
+class spsc_ring
+{
+  static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+
+  std::array<T, CAPACITY> slots{};
+  alignas(64) std::atomic<std::size_t> head{0}; // next slot to fill, written by the producer
+  alignas(64) std::atomic<std::size_t> tail{0}; // next slot to drain, written by the consumer
+
+public:
+  T* producer_slot()
+  {
+    auto h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) == CAPACITY)
+      return nullptr;
+    return &slots[h % CAPACITY];
+  }
+
+  void push() { head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+  T* consumer_slot()
+  {
+    auto t = tail.load(std::memory_order_relaxed);
+    if (head.load(std::memory_order_acquire) == t)
+      return nullptr;
+    return &slots[t % CAPACITY];
+  }
+
+  void pop() { tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+  bool try_push(const T& value)
+  {
+    auto slot = producer_slot();
+    if (slot == nullptr)
+      return false;
+    *slot = value;
+    push();
+    return true;
+  }
+
+  bool try_pop(T& value)
+  {
+    auto slot = consumer_slot();
+    if (slot == nullptr)
+      return false;
+    value = *slot;
+    pop();
+    return true;
+  }
+
+  // Approximate when read from the other thread
+  std::size_t size() const { return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire); }
+};
+} // namespace champsim
+
+#endif
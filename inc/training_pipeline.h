@@ -0,0 +1,232 @@
+#ifndef TRAINING_PIPELINE_H
+#define TRAINING_PIPELINE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "spsc_ring.h"
+
+namespace champsim
+{
+/*
+ * Decoupled predictor training
+ *
+ * A policy submits its training events to a training_pipeline instead of applying them, and the pipeline applies them
+ * with the policy's function in the mode chosen by <PREFIX>_TRAINING:
+ *
+ *   unset      each event is applied as it is submitted, exactly as if there were no pipeline
+ *   async      events go through an spsc_ring to a helper thread, so the simulation thread only does inference. It waits
+ *              only while <PREFIX>_TRAINING_LAG events (default and at most CAPACITY) are outstanding, which bounds how
+ *              stale the predictor can be. Either side polls SPIN_POLLS times and then blocks, so an idle helper does
+ *              not hold a core. Results depend on thread timing.
+ *   deterministic
+ *              events are buffered and applied in order every <PREFIX>_TRAINING_INTERVAL accesses (default
+ *              DEFAULT_INTERVAL), on the simulation thread. Results are reproducible and depend only on the interval.
+ *
+ * In async mode the helper writes predictor entries that the simulation thread reads, so those entries must be read
+ * with shared_load() on the inference side and written with shared_store() on the training side.
+ */
+template <typename T>
+T shared_load(const T& entry)
+{
+  return __atomic_load_n(&entry, __ATOMIC_RELAXED);
+}
+
+template <typename T>
+void shared_store(T& entry, T value)
+{
+  __atomic_store_n(&entry, value, __ATOMIC_RELAXED);
+}
+
+template <typename Event, std::size_t CAPACITY = 4096>
+class training_pipeline
+{
+public:
+  static constexpr uint64_t DEFAULT_INTERVAL = 1024;
+  static constexpr int SPIN_POLLS = 64;
+
+private:
+  enum class mode { immediate, async, deterministic };
+
+  std::function<void(const Event&)> apply;
+  mode selected = mode::immediate;
+  uint64_t lag = CAPACITY;
+  uint64_t interval = DEFAULT_INTERVAL;
+
+  // async: the helper thread is the only consumer of the ring and the only writer of applied. A side about to block
+  // announces it in helper_idle or producer_waiting, and the other side notifies it only then; each pairs its flag with
+  // a full fence so that a wakeup cannot be lost between the last poll and the wait.
+  std::unique_ptr<spsc_ring<Event, CAPACITY>> ring;
+  std::atomic<uint64_t> applied{0};
+  std::atomic<bool> stopping{false};
+  std::atomic<bool> helper_idle{false};
+  std::atomic<bool> producer_waiting{false};
+  std::mutex mutex;
+  std::condition_variable work_ready;
+  std::condition_variable work_done;
+  std::thread helper;
+
+  // deterministic
+  std::vector<Event> pending;
+  uint64_t accesses = 0;
+
+  uint64_t submitted = 0;
+  uint64_t producer_waits = 0;
+  uint64_t max_outstanding = 0;
+
+  static uint64_t env_value(const std::string& name, uint64_t fallback)
+  {
+    const char* value = std::getenv(name.c_str());
+    return value != nullptr && std::strtoull(value, nullptr, 0) > 0 ? std::strtoull(value, nullptr, 0) : fallback;
+  }
+
+  void run()
+  {
+    while (true) {
+      auto event = ring->consumer_slot();
+      for (int polls = 0; event == nullptr && polls < SPIN_POLLS && !stopping.load(std::memory_order_acquire); ++polls) {
+        std::this_thread::yield();
+        event = ring->consumer_slot();
+      }
+
+      if (event == nullptr) {
+        std::unique_lock lock{mutex};
+        helper_idle.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        work_ready.wait(lock, [&] { return (event = ring->consumer_slot()) != nullptr || stopping.load(std::memory_order_acquire); });
+        helper_idle.store(false, std::memory_order_relaxed);
+        if (event == nullptr)
+          return; // stopping, and every event has been applied
+      }
+
+      apply(*event);
+      ring->pop();
+      applied.store(applied.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (producer_waiting.load(std::memory_order_relaxed)) {
+        std::lock_guard lock{mutex};
+        work_done.notify_one();
+      }
+    }
+  }
+
+  // Wait on the simulation thread until the helper has applied target events
+  void wait_applied(uint64_t target)
+  {
+    for (int polls = 0; polls < SPIN_POLLS; ++polls) {
+      if (applied.load(std::memory_order_acquire) >= target)
+        return;
+      std::this_thread::yield();
+    }
+
+    std::unique_lock lock{mutex};
+    producer_waiting.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    work_done.wait(lock, [&] { return applied.load(std::memory_order_acquire) >= target; });
+    producer_waiting.store(false, std::memory_order_relaxed);
+  }
+
+public:
+  training_pipeline(const std::string& env_prefix, std::function<void(const Event&)> apply_) : apply(std::move(apply_))
+  {
+    const char* value = std::getenv((env_prefix + "_TRAINING").c_str());
+    std::string name = value != nullptr ? value : "";
+    if (name == "async") {
+      selected = mode::async;
+      lag = std::min<uint64_t>(env_value(env_prefix + "_TRAINING_LAG", CAPACITY), CAPACITY);
+      ring = std::make_unique<spsc_ring<Event, CAPACITY>>();
+      helper = std::thread{&training_pipeline::run, this};
+    } else if (name == "deterministic") {
+      selected = mode::deterministic;
+      interval = env_value(env_prefix + "_TRAINING_INTERVAL", DEFAULT_INTERVAL);
+    }
+  }
+
+  ~training_pipeline()
+  {
+    if (helper.joinable()) {
+      drain();
+      {
+        std::lock_guard lock{mutex};
+        stopping.store(true, std::memory_order_release);
+      }
+      work_ready.notify_one();
+      helper.join();
+    }
+  }
+
+  training_pipeline(const training_pipeline&) = delete;
+  training_pipeline& operator=(const training_pipeline&) = delete;
+
+  void submit(const Event& event)
+  {
+    if (selected == mode::immediate) {
+      apply(event);
+    } else if (selected == mode::deterministic) {
+      pending.push_back(event);
+    } else {
+      if (submitted - applied.load(std::memory_order_acquire) >= lag) {
+        ++producer_waits;
+        wait_applied(submitted + 1 - lag);
+      }
+
+      // fewer than lag <= CAPACITY events are outstanding, so the ring has room
+      auto slot = ring->producer_slot();
+      assert(slot != nullptr);
+      *slot = event;
+      ring->push();
+      max_outstanding = std::max(max_outstanding, submitted + 1 - applied.load(std::memory_order_relaxed));
+
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (helper_idle.load(std::memory_order_relaxed)) {
+        std::lock_guard lock{mutex};
+        work_ready.notify_one();
+      }
+    }
+    ++submitted;
+  }
+
+  // Count an access; in deterministic mode, every interval-th one applies the buffered events
+  void access()
+  {
+    if (selected == mode::deterministic && ++accesses % interval == 0)
+      drain();
+  }
+
+  // Apply every event submitted so far. The predictor may then be read from the simulation thread without shared_load().
+  void drain()
+  {
+    if (selected == mode::async) {
+      wait_applied(submitted);
+    } else if (selected == mode::deterministic) {
+      for (const auto& event : pending)
+        apply(event);
+      pending.clear();
+    }
+  }
+
+  void print(const std::string& name) const
+  {
+    if (selected == mode::async) {
+      std::cout << name << " TRAINING: async EVENTS: " << submitted << " LAG BOUND: " << lag << " MAX OUTSTANDING: " << max_outstanding;
+      std::cout << " PRODUCER WAITS: " << producer_waits << std::endl;
+    } else if (selected == mode::deterministic) {
+      std::cout << name << " TRAINING: deterministic EVENTS: " << submitted << " INTERVAL: " << interval << " ACCESSES" << std::endl;
+    }
+  }
+};
+} // namespace champsim
+
+#endif
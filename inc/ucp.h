@@ -0,0 +1,158 @@
+#ifndef UCP_H
+#define UCP_H
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "champsim_constants.h"
+#include "msl/bits.h"
+#include "owner_tracker.h"
+
+namespace champsim
+{
+/*
+ * Utility-based cache partitioning (Qureshi and Patt, MICRO 2006)
+ *
+ * Each core has a utility monitor (UMON): LRU shadow tags for a few sampled sets, with a hit counter per LRU stack
+ * position, so hits[c][i] estimates the extra hits core c would get from its (i+1)-th way. Every REPARTITION_INTERVAL
+ * accesses the lookahead algorithm divides the ways among the cores and the counters are halved.
+ *
+ * A policy composes with UCP by restricting its victim search to victim_mask(), which reads line owners from the policy's
+ * owner_tracker: a core under its quota replaces a line of a core over its quota, and a core at or over its quota replaces
+ * one of its own lines.
+ */
+class ucp
+{
+public:
+  static constexpr std::size_t UMON_SETS = 32;
+  static constexpr uint64_t REPARTITION_INTERVAL = 1 << 20;
+
+private:
+  std::size_t num_way;
+  std::size_t umon_interval;
+
+  std::vector<uint64_t> shadow;   // [cpu][umon set][stack position] block address + 1, 0 is invalid
+  std::vector<uint64_t> way_hits; // [cpu][stack position]
+  std::vector<unsigned> allocation;
+
+  uint64_t accesses = 0;
+  uint64_t repartitions = 0;
+
+  uint64_t utility(std::size_t cpu, unsigned from, unsigned to) const
+  {
+    uint64_t sum = 0;
+    for (auto i = from; i < to; ++i)
+      sum += way_hits[cpu * num_way + i];
+    return sum;
+  }
+
+  // Lookahead allocation: repeatedly give the next ways to the core with the highest marginal utility per way
+  void repartition()
+  {
+    std::fill(std::begin(allocation), std::end(allocation), 1);
+    auto balance = num_way - std::min(num_way, NUM_CPUS);
+
+    while (balance > 0) {
+      std::size_t winner = 0;
+      unsigned winner_ways = 1;
+      double winner_utility = -1;
+      for (std::size_t cpu = 0; cpu < NUM_CPUS; ++cpu) {
+        auto alloc = allocation[cpu];
+        for (unsigned k = 1; k <= balance && alloc + k <= num_way; ++k) {
+          auto mu = static_cast<double>(utility(cpu, alloc, alloc + k)) / k;
+          if (mu > winner_utility) {
+            winner = cpu;
+            winner_ways = k;
+            winner_utility = mu;
+          }
+        }
+      }
+
+      allocation[winner] += winner_ways;
+      balance -= winner_ways;
+    }
+
+    for (auto& h : way_hits)
+      h >>= 1;
+    ++repartitions;
+  }
+
+public:
+  ucp(std::size_t num_set_, std::size_t num_way_)
+      : num_way(num_way_), umon_interval(std::max<std::size_t>(1, num_set_ / UMON_SETS)),
+        shadow(NUM_CPUS * ((num_set_ + umon_interval - 1) / umon_interval) * num_way_), way_hits(NUM_CPUS * num_way_),
+        allocation(NUM_CPUS, static_cast<unsigned>(std::max<std::size_t>(1, num_way_ / NUM_CPUS)))
+  {
+    assert(num_way <= 64);
+  }
+
+  // Record a demand access for the utility monitors
+  void access(uint32_t cpu, uint32_t set, uint64_t full_addr)
+  {
+    if (set % umon_interval == 0) {
+      auto umon_sets = shadow.size() / (NUM_CPUS * num_way);
+      auto begin = std::next(std::begin(shadow), static_cast<long>((cpu * umon_sets + set / umon_interval) * num_way));
+      auto end = std::next(begin, static_cast<long>(num_way));
+      auto tag = (full_addr >> LOG2_BLOCK_SIZE) + 1;
+
+      // move the block to the MRU position, counting a hit at its previous stack position
+      auto found = std::find(begin, end, tag);
+      if (found != end)
+        ++way_hits[cpu * num_way + static_cast<std::size_t>(std::distance(begin, found))];
+      else
+        found = std::prev(end);
+      std::rotate(begin, found, std::next(found));
+      *begin = tag;
+    }
+
+    if (++accesses % REPARTITION_INTERVAL == 0)
+      repartition();
+  }
+
+  // Ways of the set that the requesting core may evict
+  uint64_t victim_mask(uint32_t cpu, uint32_t set, const owner_tracker& owners) const
+  {
+    // lines without an owner count against no core (the last slot), and may be replaced by any
+    std::array<unsigned, NUM_CPUS + 1> occupancy{};
+    for (uint32_t way = 0; way < num_way; ++way) {
+      auto o = owners.owner(set, way);
+      ++occupancy[o == owner_tracker::NO_OWNER ? NUM_CPUS : o];
+    }
+
+    auto select = [&](auto pred) {
+      uint64_t mask = 0;
+      for (uint32_t way = 0; way < num_way; ++way) {
+        if (pred(owners.owner(set, way)))
+          mask |= uint64_t{1} << way;
+      }
+      return mask;
+    };
+
+    uint64_t mask = 0;
+    if (occupancy[cpu] < allocation[cpu]) {
+      mask = select([&](auto o) { return o == owner_tracker::NO_OWNER || (o != cpu && occupancy[o] > allocation[o]); });
+      if (mask == 0)
+        mask = select([&](auto o) { return o != cpu; });
+    } else {
+      mask = select([&](auto o) { return o == cpu; });
+    }
+
+    return mask != 0 ? mask : champsim::bitmask(num_way);
+  }
+
+  void print(const std::string& name) const
+  {
+    std::cout << name << " UCP REPARTITIONS: " << repartitions << " ALLOCATION:";
+    for (auto a : allocation)
+      std::cout << " " << a;
+    std::cout << std::endl;
+  }
+};
+} // namespace champsim
+
+#endif
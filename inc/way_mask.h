@@ -0,0 +1,35 @@
+#ifndef WAY_MASK_H
+#define WAY_MASK_H
+
+#include <cstdint>
+#include <functional>
+
+namespace champsim
+{
+/*
+ * Victim searches restricted to the ways of a set whose bit is set in a candidate mask (bit i is way i). A policy that
+ * composes with a way partitioning scheme uses these in place of std::find and std::min_element.
+ */
+template <typename It, typename T>
+It masked_find(It begin, It end, uint64_t mask, const T& value)
+{
+  for (auto it = begin; it != end; ++it, mask >>= 1) {
+    if ((mask & 1) && *it == value)
+      return it;
+  }
+  return end;
+}
+
+template <typename It, typename Compare = std::less<>>
+It masked_min_element(It begin, It end, uint64_t mask, Compare comp = {})
+{
+  auto best = end;
+  for (auto it = begin; it != end; ++it, mask >>= 1) {
+    if ((mask & 1) && (best == end || comp(*it, *best)))
+      best = it;
+  }
+  return best;
+}
+} // namespace champsim
+
+#endif
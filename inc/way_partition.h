@@ -0,0 +1,133 @@
+#ifndef WAY_PARTITION_H
+#define WAY_PARTITION_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include "champsim_constants.h"
+#include "msl/bits.h"
+
+namespace champsim
+{
+class way_partition;
+
+// Every live way_partition, by cache name, so that masks can be changed from outside the replacement policy. The registry
+// is never destroyed, since partitions held in the policies' static maps may outlive any function-local static.
+inline std::map<std::string, way_partition*>& way_partitions()
+{
+  static auto* partitions = new std::map<std::string, way_partition*>;
+  return *partitions;
+}
+
+/*
+ * CAT-style way partitioning
+ *
+ * Each core has an allocation mask of the ways it may fill (bit i is way i); a policy restricts its victim search to
+ * victim_mask(cpu). Masks default to every way and can be changed at runtime with set_way_mask(), or through a control
+ * file named by WAY_MASK_FILE (suffixed with "." and the cache name) that is re-read whenever it is modified. Each line of
+ * the file is "<cpu> <mask>", with the mask in any base std::stoull accepts (e.g. 0x0f); '#' starts a comment. Unlike real
+ * CAT, masks need not be contiguous. A mask with no ways in the cache is rejected.
+ */
+class way_partition
+{
+public:
+  static constexpr const char* CONTROL_FILE_ENV = "WAY_MASK_FILE";
+  static constexpr uint64_t CONTROL_POLL_INTERVAL = 1 << 16; // victim searches between checks of the control file
+
+private:
+  std::string name;
+  std::size_t num_way;
+  std::vector<uint64_t> masks = std::vector<uint64_t>(NUM_CPUS);
+  uint64_t searches = 0;
+
+  std::string control_path;
+  decltype(stat::st_mtime) control_mtime = 0;
+
+  void poll_control_file()
+  {
+    struct stat st;
+    if (control_path.empty() || stat(control_path.c_str(), &st) != 0 || st.st_mtime == control_mtime)
+      return;
+    control_mtime = st.st_mtime;
+
+    std::ifstream file{control_path};
+    std::string line;
+    while (std::getline(file, line)) {
+      std::istringstream fields{line.substr(0, line.find('#'))};
+      std::string cpu, mask;
+      if (!(fields >> cpu >> mask))
+        continue;
+
+      try {
+        if (!set_mask(static_cast<uint32_t>(std::stoul(cpu)), std::stoull(mask, nullptr, 0)))
+          std::cerr << name << " WAY PARTITION: ignoring mask " << mask << " for cpu " << cpu << std::endl;
+      } catch (const std::logic_error&) {
+        std::cerr << name << " WAY PARTITION: cannot parse \"" << line << "\" in " << control_path << std::endl;
+      }
+    }
+  }
+
+public:
+  way_partition(std::string name_, std::size_t num_way_) : name(std::move(name_)), num_way(num_way_)
+  {
+    for (auto& m : masks)
+      m = champsim::bitmask(num_way);
+
+    if (const char* path = std::getenv(CONTROL_FILE_ENV); path != nullptr && *path != '\0')
+      control_path = std::string{path} + "." + name;
+    poll_control_file();
+
+    way_partitions()[name] = this;
+  }
+
+  ~way_partition() { way_partitions().erase(name); }
+
+  way_partition(const way_partition&) = delete;
+  way_partition& operator=(const way_partition&) = delete;
+
+  // Returns false, leaving the mask unchanged, if cpu is out of range or the mask has no ways in the cache
+  bool set_mask(uint32_t cpu, uint64_t mask)
+  {
+    mask &= champsim::bitmask(num_way);
+    if (cpu >= NUM_CPUS || mask == 0)
+      return false;
+    masks[cpu] = mask;
+    return true;
+  }
+
+  // Ways the core may fill, called once per victim search
+  uint64_t victim_mask(uint32_t cpu)
+  {
+    if (++searches % CONTROL_POLL_INTERVAL == 0)
+      poll_control_file();
+    return masks[cpu];
+  }
+
+  void print() const
+  {
+    std::cout << name << " WAY PARTITION MASKS:" << std::hex;
+    for (auto m : masks)
+      std::cout << " 0x" << m;
+    std::cout << std::dec << std::endl;
+  }
+};
+
+// Change a core's allocation mask in the named cache. Returns false if there is no such cache or the mask was rejected.
+inline bool set_way_mask(const std::string& cache_name, uint32_t cpu, uint64_t mask)
+{
+  auto found = way_partitions().find(cache_name);
+  return found != std::end(way_partitions()) && found->second->set_mask(cpu, mask);
+}
+} // namespace champsim
+
+#endif
@@ -0,0 +1,142 @@
+#ifndef WRITEBACK_POLICY_H
+#define WRITEBACK_POLICY_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <initializer_list>
+#include <iostream>
+#include <string>
+#include <utility>
+
+#include "cache.h"
+#include "packed_counters.h"
+
+namespace champsim
+{
+/*
+ * Writeback insertion, promotion and clean-line preference, shared by every policy
+ *
+ * At the LLC, access_type::WRITE is a dirty eviction from the level above. Each policy maps two abstract placements onto
+ * its own state: "distant" (the next line it would evict) and "near" (the last). The placement of writebacks is chosen at
+ * startup from the environment:
+ *
+ *   WRITEBACK_INSERTION    policy | distant | near   placement of a writeback miss
+ *   WRITEBACK_PROMOTION    policy | promote | keep   on a writeback hit, move the line near or leave it where it is
+ *   WRITEBACK_PREFER_CLEAN 0 | 1                     evict clean lines before dirty ones, to cut write traffic
+ *
+ * "policy" keeps each policy's own handling. The class also keeps a dirty bit for every line, to report how many
+ * evictions were dirty.
+ */
+class writeback_policy
+{
+public:
+  enum class placement { policy, distant, near, none };
+
+private:
+  placement insertion = placement::policy;
+  placement promotion = placement::policy;
+  bool prefer_clean = false;
+
+  std::size_t num_way;
+  packed_counters<1> dirty;
+
+  uint64_t dirty_evictions = 0;
+  uint64_t clean_preferred = 0;
+
+  static placement parse(const char* env, std::initializer_list<std::pair<const char*, placement>> choices)
+  {
+    const char* value = std::getenv(env);
+    if (value == nullptr || *value == '\0')
+      return placement::policy;
+    for (auto [name, p] : choices) {
+      if (std::string{value} == name)
+        return p;
+    }
+    std::cerr << env << ": unknown value \"" << value << "\", using the policy's own handling" << std::endl;
+    return placement::policy;
+  }
+
+  static const char* name_of(placement p)
+  {
+    switch (p) {
+    case placement::distant:
+      return "distant";
+    case placement::near:
+      return "near";
+    case placement::none:
+      return "keep";
+    default:
+      return "policy";
+    }
+  }
+
+public:
+  writeback_policy(std::size_t num_set, std::size_t num_way_) : num_way(num_way_), dirty(num_set, num_way_)
+  {
+    insertion = parse("WRITEBACK_INSERTION", {{"policy", placement::policy}, {"distant", placement::distant}, {"near", placement::near}});
+    promotion = parse("WRITEBACK_PROMOTION", {{"policy", placement::policy}, {"promote", placement::near}, {"keep", placement::none}});
+    const char* clean = std::getenv("WRITEBACK_PREFER_CLEAN");
+    prefer_clean = clean != nullptr && *clean != '\0' && std::string{clean} != "0";
+  }
+
+  // Called on every hit and fill, before the policy updates the line
+  void update(uint32_t set, uint32_t way, uint32_t type, uint8_t hit)
+  {
+    if (way >= num_way)
+      return;
+
+    if (!hit) {
+      dirty_evictions += dirty.get(set, way);
+      dirty.set(set, way, 0);
+    }
+    if (access_type{type} == access_type::WRITE)
+      dirty.set(set, way, 1);
+  }
+
+  // Where to place a writeback, or placement::policy to let the policy handle it
+  placement place(uint8_t hit) const { return hit ? promotion : insertion; }
+
+  // Apply the configured placement to a writeback through the policy's own distant and near operations. Returns false if the
+  // access is not a writeback or the policy's own handling was configured.
+  template <typename Distant, typename Near>
+  bool apply(uint32_t type, uint8_t hit, Distant&& to_distant, Near&& to_near) const
+  {
+    if (access_type{type} != access_type::WRITE)
+      return false;
+
+    switch (place(hit)) {
+    case placement::distant:
+      to_distant();
+      return true;
+    case placement::near:
+      to_near();
+      return true;
+    case placement::none:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  // Prefer clean candidates, if configured and there are any
+  uint64_t filter(uint32_t set, uint64_t candidates)
+  {
+    if (!prefer_clean)
+      return candidates;
+
+    auto clean = candidates & ~dirty.nonzero_mask(set);
+    if (clean == 0 || clean == candidates)
+      return candidates;
+    ++clean_preferred;
+    return clean;
+  }
+
+  void print(const std::string& name) const
+  {
+    std::cout << name << " WRITEBACK INSERTION: " << name_of(insertion) << " PROMOTION: " << name_of(promotion) << " PREFER CLEAN: " << prefer_clean;
+    std::cout << " DIRTY EVICT: " << dirty_evictions << " CLEAN PREFERRED: " << clean_preferred << std::endl;
+  }
+};
+} // namespace champsim
+
+#endif
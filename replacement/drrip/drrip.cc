@@ -1,10 +1,29 @@
 #include <algorithm>
 #include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
 #include <map>
+#include <memory>
+#include <string>
 #include <utility>
 
+#include "access_breakdown.h"
+#include "async_trace_writer.h"
 #include "cache.h"
+#include "metadata_prefetch.h"
 #include "msl/fwcounter.h"
+#include "owner_tracker.h"
+#include "presence_hints.h"
+#include "psel_trace.h"
+#include "replacement_batch.h"
+#include "reuse_profiler.h"
+#include "sampler_sets.h"
+#include "set_sampling.h"
+#include "way_mask.h"
+#include "way_partition.h"
+#include "writeback_policy.h"
 
 namespace
 {
@@ -15,91 +34,210 @@ constexpr std::size_t TOTAL_SDM_SETS = NUM_CPUS * NUM_POLICY * SDM_SIZE;
 constexpr unsigned BIP_MAX = 32;
 constexpr unsigned PSEL_WIDTH = 10;
 
+// Set DRRIP_PSEL_TRACE to write a binary trace of every core's PSEL to that path, with ".<cache name>" appended. PSEL is
+// sampled every DRRIP_PSEL_SAMPLE misses of the core (default PSEL_SAMPLE_INTERVAL), and every policy switch is recorded.
+// tools/psel_trace_summary.cc reads the trace.
+constexpr const char* PSEL_TRACE_ENV = "DRRIP_PSEL_TRACE";
+constexpr const char* PSEL_SAMPLE_ENV = "DRRIP_PSEL_SAMPLE";
+constexpr uint64_t PSEL_SAMPLE_INTERVAL = 1024;
+
+struct psel_tracer {
+  std::string path;
+  std::unique_ptr<champsim::async_trace_writer<champsim::psel_trace_record>> writer;
+  uint64_t sample_interval = PSEL_SAMPLE_INTERVAL;
+  std::vector<uint64_t> misses = std::vector<uint64_t>(NUM_CPUS);
+  uint64_t records = 0;
+};
+
 std::map<CACHE*, unsigned> bip_counter;
-std::map<CACHE*, std::vector<std::size_t>> rand_sets;
+std::map<CACHE*, champsim::sampler_sets> rand_sets;
 std::map<std::pair<CACHE*, std::size_t>, champsim::msl::fwcounter<PSEL_WIDTH>> PSEL;
 std::map<CACHE*, std::vector<unsigned>> rrpv;
+std::map<CACHE*, champsim::way_partition> cat_partition;
+std::map<CACHE*, champsim::owner_tracker> owners;
+std::map<CACHE*, champsim::presence_hints> presence;
+std::map<CACHE*, champsim::writeback_policy> writebacks;
+std::map<CACHE*, champsim::access_breakdown> breakdown;
+std::map<CACHE*, champsim::reuse_profiler> reuse;
+std::map<CACHE*, champsim::set_sampling> sampling;
+std::map<CACHE*, psel_tracer> psel_trace;
+
+// Count a miss by cpu, and record its PSEL if it is due for a sample or crossed the midpoint since was_bip was taken
+void trace_psel(CACHE* cache, uint32_t cpu, bool was_bip)
+{
+  auto& trace = ::psel_trace[cache];
+  if (!trace.writer)
+    return;
+
+  auto selector = ::PSEL[std::make_pair(cache, cpu)];
+  bool is_bip = selector.value() > (selector.maximum / 2);
+  auto misses = ++trace.misses[cpu];
+  auto record = [&](champsim::psel_event event) {
+    trace.writer->append({cache->current_cycle, misses, static_cast<uint16_t>(cpu), static_cast<uint16_t>(selector.value()), event, {}});
+    ++trace.records;
+  };
+
+  if (is_bip != was_bip)
+    record(is_bip ? champsim::psel_event::to_bip : champsim::psel_event::to_srrip);
+  if (misses % trace.sample_interval == 0)
+    record(champsim::psel_event::sample);
+}
+
+// applies a batch of hits and fills, defined below and registered for each cache by initialize_replacement()
+void update_batch(CACHE* cache, const champsim::replacement_access* first, const champsim::replacement_access* last);
 } // namespace
 
 void CACHE::initialize_replacement()
 {
   // randomly selected sampler sets
-  std::size_t rand_seed = 1103515245 + 12345;
-  for (std::size_t i = 0; i < ::TOTAL_SDM_SETS; i++) {
-    std::size_t val = (rand_seed / 65536) % NUM_SET;
-    auto loc = std::lower_bound(std::begin(::rand_sets[this]), std::end(::rand_sets[this]), val);
-
-    while (loc != std::end(::rand_sets[this]) && *loc == val) {
-      rand_seed = rand_seed * 1103515245 + 12345;
-      val = (rand_seed / 65536) % NUM_SET;
-      loc = std::lower_bound(std::begin(::rand_sets[this]), std::end(::rand_sets[this]), val);
-    }
+  ::rand_sets.emplace(this, champsim::sampler_sets{NUM_SET, ::TOTAL_SDM_SETS});
+
+  ::rrpv.insert({this, std::vector<unsigned>(NUM_SET * NUM_WAY)});
+  ::cat_partition.try_emplace(this, NAME, NUM_WAY);
+  ::owners.emplace(this, champsim::owner_tracker{NUM_SET, NUM_WAY});
+  ::presence.try_emplace(this, NAME, NUM_SET, NUM_WAY);
+  ::writebacks.emplace(this, champsim::writeback_policy{NUM_SET, NUM_WAY});
+  ::breakdown.emplace(this, champsim::access_breakdown{NAME, NUM_SET, NUM_WAY});
+  ::reuse.emplace(this, champsim::reuse_profiler{NUM_SET});
+  ::sampling.emplace(this, champsim::set_sampling{NUM_SET, NUM_WAY});
+  ::sampling.at(this).include(::rand_sets.at(this));
 
-    ::rand_sets[this].insert(loc, val);
+  if (const char* path = std::getenv(::PSEL_TRACE_ENV); path != nullptr && *path != '\0') {
+    auto& trace = ::psel_trace[this];
+    trace.path = std::string{path} + "." + NAME;
+    if (const char* interval = std::getenv(::PSEL_SAMPLE_ENV); interval != nullptr && std::strtoull(interval, nullptr, 0) > 0)
+      trace.sample_interval = std::strtoull(interval, nullptr, 0);
+
+    champsim::psel_trace_header header{};
+    std::memcpy(header.magic, champsim::PSEL_TRACE_MAGIC, sizeof(header.magic));
+    header.version = champsim::PSEL_TRACE_VERSION;
+    header.num_cpus = NUM_CPUS;
+    header.psel_max = champsim::msl::fwcounter<::PSEL_WIDTH>::maximum;
+    header.sample_interval = trace.sample_interval;
+    trace.writer = std::make_unique<champsim::async_trace_writer<champsim::psel_trace_record>>(trace.path, header);
   }
 
-  ::rrpv.insert({this, std::vector<unsigned>(NUM_SET * NUM_WAY)});
+  // for callers that batch their updates (see replacement_batch.h)
+  champsim::replacement_batches()[NAME] = [this](const champsim::replacement_access* first, const champsim::replacement_access* last) {
+    ::update_batch(this, first, last);
+  };
 }
 
-// called on every cache hit and cache fill
-void CACHE::update_replacement_state(uint32_t triggering_cpu, uint32_t set, uint32_t way, uint64_t full_addr, uint64_t ip, uint64_t victim_addr, uint32_t type,
-                                     uint8_t hit)
+namespace
 {
-  // do not update replacement state for writebacks
-  if (access_type{type} == access_type::WRITE) {
-    ::rrpv[this][set * NUM_WAY + way] = ::maxRRPV - 1;
-    return;
-  }
+// called with runs of hits and fills to one set
+void update_batch(CACHE* cache, const champsim::replacement_access* first, const champsim::replacement_access* last)
+{
+  auto& rrpv = ::rrpv[cache];
+  auto& rand_sets = ::rand_sets.at(cache);
+  auto& bip_counter = ::bip_counter[cache];
+  auto& owners = ::owners.at(cache);
+  auto& presence = ::presence.at(cache);
+  auto& writebacks = ::writebacks.at(cache);
+  auto& breakdown = ::breakdown.at(cache);
+  auto& reuse = ::reuse.at(cache);
+  auto& sampling = ::sampling.at(cache);
 
-  // cache hit
-  if (hit) {
-    ::rrpv[this][set * NUM_WAY + way] = 0; // for cache hit, DRRIP always promotes a cache line to the MRU position
-    return;
-  }
+  auto prefetch_set = [&](uint32_t set) { champsim::prefetch_range(rrpv.data() + std::size_t{set} * cache->NUM_WAY, cache->NUM_WAY); };
+
+  champsim::for_each_set_run(first, last, prefetch_set, [&](const champsim::set_run& run) {
+    if (!sampling.modeled(run.set()))
+      return;
 
-  // cache miss
-  auto begin = std::next(std::begin(::rand_sets[this]), triggering_cpu * ::NUM_POLICY * ::SDM_SIZE);
-  auto end = std::next(begin, ::NUM_POLICY * ::SDM_SIZE);
-  auto leader = std::find(begin, end, set);
+    auto set_rrpv = rrpv.data() + std::size_t{run.set()} * cache->NUM_WAY;
 
-  if (leader == end) { // follower sets
-    auto selector = ::PSEL[std::make_pair(this, triggering_cpu)];
-    if (selector.value() > (selector.maximum / 2)) { // follow BIP
-      ::rrpv[this][set * NUM_WAY + way] = ::maxRRPV;
+    for (const auto& [triggering_cpu, set, way, full_addr, ip, victim_addr, type, hit] : run) {
+      sampling.record(set, type, hit);
+      if (!hit)
+        owners.miss(triggering_cpu, set, way, full_addr, victim_addr);
+      presence.update(set, way, full_addr, type, hit);
+      writebacks.update(set, way, type, hit);
+      breakdown.update(triggering_cpu, set, way, type, hit);
+      reuse.access(triggering_cpu, set, full_addr, type);
 
-      ::bip_counter[this]++;
-      if (::bip_counter[this] == ::BIP_MAX) {
-        ::bip_counter[this] = 0;
-        ::rrpv[this][set * NUM_WAY + way] = ::maxRRPV - 1;
+      // the fill was bypassed, there is no line to update
+      if (way == cache->NUM_WAY)
+        continue;
+
+      auto& line_rrpv = set_rrpv[way];
+      if (writebacks.apply(type, hit, [&] { line_rrpv = ::maxRRPV; }, [&] { line_rrpv = 0; }))
+        continue;
+
+      // do not update replacement state for writebacks
+      if (access_type{type} == access_type::WRITE) {
+        line_rrpv = ::maxRRPV - 1;
+        continue;
       }
-    } else { // follow SRRIP
-      ::rrpv[this][set * NUM_WAY + way] = ::maxRRPV - 1;
-    }
-  } else if (leader == begin) { // leader 0: BIP
-    ::PSEL[std::make_pair(this, triggering_cpu)]--;
-    ::rrpv[this][set * NUM_WAY + way] = ::maxRRPV;
-
-    ::bip_counter[this]++;
-    if (::bip_counter[this] == ::BIP_MAX) {
-      ::bip_counter[this] = 0;
-      ::rrpv[this][set * NUM_WAY + way] = ::maxRRPV - 1;
+
+      // cache hit
+      if (hit) {
+        line_rrpv = 0; // for cache hit, DRRIP always promotes a cache line to the MRU position
+        continue;
+      }
+
+      // cache miss
+      auto& psel = ::PSEL[std::make_pair(cache, triggering_cpu)];
+      auto was_bip = psel.value() > (champsim::msl::fwcounter<::PSEL_WIDTH>::maximum / 2);
+      auto begin = std::next(std::begin(rand_sets), triggering_cpu * ::NUM_POLICY * ::SDM_SIZE);
+      auto end = std::next(begin, ::NUM_POLICY * ::SDM_SIZE);
+      auto leader = std::find(begin, end, set);
+
+      if (leader == end) { // follower sets
+        if (psel.value() > (psel.maximum / 2)) { // follow BIP
+          line_rrpv = ::maxRRPV;
+
+          bip_counter++;
+          if (bip_counter == ::BIP_MAX) {
+            bip_counter = 0;
+            line_rrpv = ::maxRRPV - 1;
+          }
+        } else { // follow SRRIP
+          line_rrpv = ::maxRRPV - 1;
+        }
+      } else if (leader == begin) { // leader 0: BIP
+        psel--;
+        line_rrpv = ::maxRRPV;
+
+        bip_counter++;
+        if (bip_counter == ::BIP_MAX) {
+          bip_counter = 0;
+          line_rrpv = ::maxRRPV - 1;
+        }
+      } else if (leader == std::next(begin)) { // leader 1: SRRIP
+        psel++;
+        line_rrpv = ::maxRRPV - 1;
+      }
+
+      ::trace_psel(cache, triggering_cpu, was_bip);
     }
-  } else if (leader == std::next(begin)) { // leader 1: SRRIP
-    ::PSEL[std::make_pair(this, triggering_cpu)]++;
-    ::rrpv[this][set * NUM_WAY + way] = ::maxRRPV - 1;
-  }
+  });
+}
+} // namespace
+
+// called on every cache hit and cache fill
+void CACHE::update_replacement_state(uint32_t triggering_cpu, uint32_t set, uint32_t way, uint64_t full_addr, uint64_t ip, uint64_t victim_addr, uint32_t type,
+                                     uint8_t hit)
+{
+  champsim::replacement_access access{triggering_cpu, set, way, full_addr, ip, victim_addr, type, hit};
+  ::update_batch(this, &access, &access + 1);
 }
 
 // find replacement victim
 uint32_t CACHE::find_victim(uint32_t triggering_cpu, uint64_t instr_id, uint32_t set, const BLOCK* current_set, uint64_t ip, uint64_t full_addr, uint32_t type)
 {
+  if (!::sampling.at(this).modeled(set))
+    return ::sampling.at(this).skipped_victim(set);
+
   // look for the maxRRPV line
   auto begin = std::next(std::begin(::rrpv[this]), set * NUM_WAY);
   auto end = std::next(begin, NUM_WAY);
 
-  auto victim = std::max_element(begin, end);
+  auto candidates = ::presence.at(this).filter(set, ::cat_partition.at(this).victim_mask(triggering_cpu));
+  candidates = ::writebacks.at(this).filter(set, candidates);
+  auto victim = champsim::masked_min_element(begin, end, candidates, std::greater<>{});
+  auto age = ::maxRRPV - *victim;
   for (auto it = begin; it != end; ++it)
-    *it += ::maxRRPV - *victim;
+    *it = std::min(*it + age, ::maxRRPV); // lines outside the mask may already be at maxRRPV
 
   assert(begin <= victim);
   assert(victim < end);
@@ -107,4 +245,18 @@ uint32_t CACHE::find_victim(uint32_t triggering_cpu, uint64_t instr_id, uint32_t
 }
 
 // use this function to print out your own stats at the end of simulation
-void CACHE::replacement_final_stats() {}
+void CACHE::replacement_final_stats()
+{
+  ::cat_partition.at(this).print();
+  ::owners.at(this).print(NAME);
+  ::presence.at(this).print();
+  ::writebacks.at(this).print(NAME);
+  ::breakdown.at(this).print();
+  ::reuse.at(this).print(NAME);
+  ::sampling.at(this).print(NAME);
+
+  if (auto& trace = ::psel_trace[this]; trace.writer) {
+    trace.writer->close();
+    std::cout << NAME << " PSEL TRACE: " << trace.path << " RECORDS: " << trace.records << (trace.writer->good() ? "" : " (write failed)") << std::endl;
+  }
+}
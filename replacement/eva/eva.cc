@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <vector>
+
+#include "access_breakdown.h"
+#include "cache.h"
+#include "owner_tracker.h"
+#include "packed_counters.h"
+#include "presence_hints.h"
+#include "replacement_batch.h"
+#include "reuse_profiler.h"
+#include "set_sampling.h"
+#include "way_partition.h"
+#include "writeback_policy.h"
+
+/*
+ * Economic value added (Beckmann and Sanchez, HPCA 2016)
+ *
+ * Each line has a coarse age, counted in ticks of AGE_GRANULARITY accesses to its set and saturating at MAX_AGE. The policy
+ * keeps histograms of the ages at which lines hit and are evicted, and every RECOMPUTE_INTERVAL accesses derives from them
+ * each age's EVA: the expected hits a line of that age will still earn, minus the hits the cache forgoes by holding it for
+ * its expected remaining lifetime. Ages are then ranked by EVA, so find_victim is a rank lookup per way and an argmax.
+ */
+namespace
+{
+constexpr unsigned AGE_BITS = 8;
+constexpr unsigned MAX_AGE = champsim::packed_counters<AGE_BITS>::maximum;
+constexpr unsigned AGE_GRANULARITY = 2;          // set accesses per age tick
+constexpr uint64_t RECOMPUTE_INTERVAL = 1 << 15; // accesses between EVA recomputations
+constexpr unsigned HISTOGRAM_DECAY_SHIFT = 1;    // the histograms are halved after each recomputation
+
+struct eva_state {
+  std::vector<uint64_t> hit_ages = std::vector<uint64_t>(MAX_AGE + 1);
+  std::vector<uint64_t> evict_ages = std::vector<uint64_t>(MAX_AGE + 1);
+  std::vector<double> eva = std::vector<double>(MAX_AGE + 1);
+  std::vector<uint16_t> rank = std::vector<uint16_t>(MAX_AGE + 1); // higher rank is evicted first
+  uint64_t accesses = 0;
+  uint64_t recomputations = 0;
+};
+
+std::map<CACHE*, eva_state> state;
+std::map<CACHE*, champsim::packed_counters<AGE_BITS>> age;
+std::map<CACHE*, std::vector<uint8_t>> set_clock;
+std::map<CACHE*, champsim::way_partition> cat_partition;
+std::map<CACHE*, champsim::owner_tracker> owners;
+std::map<CACHE*, champsim::presence_hints> presence;
+std::map<CACHE*, champsim::writeback_policy> writebacks;
+std::map<CACHE*, champsim::access_breakdown> breakdown;
+std::map<CACHE*, champsim::reuse_profiler> reuse;
+std::map<CACHE*, champsim::set_sampling> sampling;
+
+void recompute(eva_state& s, std::size_t lines_per_set)
+{
+  auto total_hits = static_cast<double>(std::accumulate(std::begin(s.hit_ages), std::end(s.hit_ages), uint64_t{0}));
+  auto total_events = total_hits + static_cast<double>(std::accumulate(std::begin(s.evict_ages), std::end(s.evict_ages), uint64_t{0}));
+  if (total_events == 0)
+    return;
+
+  // the hits per tick a line must earn just to pay for the space it occupies
+  auto line_gain = (total_hits / total_events) * AGE_GRANULARITY / static_cast<double>(lines_per_set);
+
+  // walk down from the oldest age, accumulating the outcomes of lines that survive to each age and their remaining lifetime
+  double hits_above = 0, events_above = 0, lifetime_above = 0;
+  double lowest = 0;
+  for (auto a = static_cast<int>(MAX_AGE); a >= 0; --a) {
+    lifetime_above += events_above;
+    hits_above += static_cast<double>(s.hit_ages[a]);
+    events_above += static_cast<double>(s.hit_ages[a] + s.evict_ages[a]);
+    s.eva[a] = events_above > 0 ? (hits_above - line_gain * lifetime_above) / events_above : 0;
+    lowest = std::min(lowest, s.eva[a]);
+  }
+
+  // no line has been seen to live this long: nothing suggests it will be reused
+  for (auto a = static_cast<int>(MAX_AGE); a >= 0 && s.hit_ages[a] + s.evict_ages[a] == 0 && s.eva[a] == 0; --a)
+    s.eva[a] = lowest - 1;
+
+  // rank ages from highest EVA (kept) to lowest (evicted first)
+  std::vector<uint16_t> order(MAX_AGE + 1);
+  std::iota(std::begin(order), std::end(order), 0);
+  std::stable_sort(std::begin(order), std::end(order), [&eva = s.eva](auto x, auto y) { return eva[x] > eva[y]; });
+  for (std::size_t r = 0; r < order.size(); ++r)
+    s.rank[order[r]] = static_cast<uint16_t>(r);
+
+  for (auto& h : s.hit_ages)
+    h >>= HISTOGRAM_DECAY_SHIFT;
+  for (auto& e : s.evict_ages)
+    e >>= HISTOGRAM_DECAY_SHIFT;
+  ++s.recomputations;
+}
+
+// applies a batch of hits and fills, defined below and registered for each cache by initialize_replacement()
+void update_batch(CACHE* cache, const champsim::replacement_access* first, const champsim::replacement_access* last);
+} // namespace
+
+void CACHE::initialize_replacement()
+{
+  // until the first recomputation, evict the oldest line
+  std::iota(std::begin(::state[this].rank), std::end(::state[this].rank), 0);
+  ::age.emplace(this, champsim::packed_counters<::AGE_BITS>{NUM_SET, NUM_WAY});
+  ::set_clock[this] = std::vector<uint8_t>(NUM_SET);
+  ::cat_partition.try_emplace(this, NAME, NUM_WAY);
+  ::owners.emplace(this, champsim::owner_tracker{NUM_SET, NUM_WAY});
+  ::presence.try_emplace(this, NAME, NUM_SET, NUM_WAY);
+  ::writebacks.emplace(this, champsim::writeback_policy{NUM_SET, NUM_WAY});
+  ::breakdown.emplace(this, champsim::access_breakdown{NAME, NUM_SET, NUM_WAY});
+  ::reuse.emplace(this, champsim::reuse_profiler{NUM_SET});
+  ::sampling.emplace(this, champsim::set_sampling{NUM_SET, NUM_WAY});
+
+  // for callers that batch their updates (see replacement_batch.h)
+  champsim::replacement_batches()[NAME] = [this](const champsim::replacement_access* first, const champsim::replacement_access* last) {
+    ::update_batch(this, first, last);
+  };
+}
+
+// find replacement victim
+uint32_t CACHE::find_victim(uint32_t triggering_cpu, uint64_t instr_id, uint32_t set, const BLOCK* current_set, uint64_t ip, uint64_t full_addr, uint32_t type)
+{
+  if (!::sampling.at(this).modeled(set))
+    return ::sampling.at(this).skipped_victim(set);
+
+  auto& s = ::state[this];
+  auto& ages = ::age.at(this);
+  auto candidates = ::presence.at(this).filter(set, ::cat_partition.at(this).victim_mask(triggering_cpu));
+  candidates = ::writebacks.at(this).filter(set, candidates);
+
+  auto victim = static_cast<uint32_t>(__builtin_ctzll(candidates));
+  for (uint32_t way = victim + 1; way < NUM_WAY; ++way) {
+    if (((candidates >> way) & 1) && s.rank[ages.get(set, way)] > s.rank[ages.get(set, victim)])
+      victim = way;
+  }
+
+  ++s.evict_ages[ages.get(set, victim)];
+  return victim;
+}
+
+namespace
+{
+// called with runs of hits and fills to one set
+void update_batch(CACHE* cache, const champsim::replacement_access* first, const champsim::replacement_access* last)
+{
+  auto& s = ::state[cache];
+  auto& set_clock = ::set_clock[cache];
+  auto& ages = ::age.at(cache);
+  auto& owners = ::owners.at(cache);
+  auto& presence = ::presence.at(cache);
+  auto& writebacks = ::writebacks.at(cache);
+  auto& breakdown = ::breakdown.at(cache);
+  auto& reuse = ::reuse.at(cache);
+  auto& sampling = ::sampling.at(cache);
+
+  auto prefetch_set = [&](uint32_t set) { ages.prefetch_row(set); };
+
+  champsim::for_each_set_run(first, last, prefetch_set, [&](const champsim::set_run& run) {
+    if (!sampling.modeled(run.set()))
+      return;
+
+    auto& clock = set_clock[run.set()];
+
+    for (const auto& access : run) {
+      const auto& [triggering_cpu, set, way, full_addr, ip, victim_addr, type, hit] = access;
+      sampling.record(set, type, hit);
+      if (!hit)
+        owners.miss(triggering_cpu, set, way, full_addr, victim_addr);
+      presence.update(set, way, full_addr, type, hit);
+      writebacks.update(set, way, type, hit);
+      breakdown.update(triggering_cpu, set, way, type, hit);
+      reuse.access(triggering_cpu, set, full_addr, type);
+
+      // age the set by one tick every AGE_GRANULARITY accesses
+      if (++clock == ::AGE_GRANULARITY) {
+        clock = 0;
+        ages.increment_range(set, 0, cache->NUM_WAY);
+      }
+
+      if (writebacks.apply(type, hit, [&] { ages.set(access.set, access.way, ::MAX_AGE); }, [&] { ages.set(access.set, access.way, 0); }))
+        continue;
+
+      if (hit && access_type{type} == access_type::WRITE) // Skip this for writeback hits
+        continue;
+
+      if (hit)
+        ++s.hit_ages[ages.get(set, way)];
+      ages.set(set, way, 0);
+
+      if (++s.accesses % ::RECOMPUTE_INTERVAL == 0)
+        ::recompute(s, cache->NUM_WAY);
+    }
+  });
+}
+} // namespace
+
+// called on every cache hit and cache fill
+void CACHE::update_replacement_state(uint32_t triggering_cpu, uint32_t set, uint32_t way, uint64_t full_addr, uint64_t ip, uint64_t victim_addr, uint32_t type,
+                                     uint8_t hit)
+{
+  champsim::replacement_access access{triggering_cpu, set, way, full_addr, ip, victim_addr, type, hit};
+  ::update_batch(this, &access, &access + 1);
+}
+
+// use this function to print out your own stats at the end of simulation
+void CACHE::replacement_final_stats()
+{
+  ::cat_partition.at(this).print();
+  ::owners.at(this).print(NAME);
+  ::presence.at(this).print();
+  ::writebacks.at(this).print(NAME);
+  ::breakdown.at(this).print();
+  ::reuse.at(this).print(NAME);
+  ::sampling.at(this).print(NAME);
+  std::cout << NAME << " EVA RECOMPUTATIONS: " << ::state[this].recomputations << std::endl;
+}
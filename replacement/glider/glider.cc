@@ -0,0 +1,285 @@
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "access_breakdown.h"
+#include "cache.h"
+#include "optgen.h"
+#include "owner_tracker.h"
+#include "packed_counters.h"
+#include "presence_hints.h"
+#include "replacement_batch.h"
+#include "reuse_profiler.h"
+#include "sampler_sets.h"
+#include "set_sampling.h"
+#include "way_partition.h"
+#include "writeback_policy.h"
+
+/*
+ * Glider (Shi, Huang, Jain and Lin, MICRO 2019)
+ *
+ * Each core keeps an unordered history of its last PCHR_SIZE distinct PCs. Every PC owns an integer SVM: a row of
+ * ISVM_WEIGHTS signed 8-bit weights, indexed by a hash of a history PC. The prediction for an access is the sum of the
+ * weights selected by the current history in the current PC's row. OPTgen on sampled sets provides the labels; a weight
+ * vector is only updated while its sum is on the wrong side of, or within TRAIN_THRESHOLD of, the label.
+ *
+ * The prediction picks the insertion RRPV: high-confidence friendly lines at 0, low-confidence friendly lines at
+ * LOW_CONFIDENCE_RRPV, averse lines at maxRRPV.
+ */
+namespace
+{
+constexpr unsigned RRPV_BITS = 3;
+constexpr unsigned maxRRPV = champsim::packed_counters<RRPV_BITS>::maximum;
+constexpr unsigned LOW_CONFIDENCE_RRPV = 2;
+constexpr std::size_t SAMPLER_SET = 64 * NUM_CPUS;
+constexpr std::size_t OPTGEN_VECTOR_MULT = 8;
+constexpr std::size_t HISTORY_MULT = 8;
+constexpr std::size_t PCHR_SIZE = 5;
+constexpr std::size_t ISVM_TABLE_SIZE = 2048; // per core
+constexpr std::size_t ISVM_WEIGHTS = 16;
+constexpr int HIGH_CONFIDENCE = 60;
+constexpr int TRAIN_THRESHOLD = 100;
+
+using pchr_type = std::array<uint64_t, PCHR_SIZE>;   // most recent first
+using feature_type = std::array<uint8_t, PCHR_SIZE>; // weight index selected by each history PC
+
+struct history_entry {
+  bool valid = false;
+  uint64_t block = 0;
+  uint32_t isvm = 0;
+  feature_type features{};
+  uint64_t last_access = 0;
+};
+
+std::map<CACHE*, champsim::sampler_sets> rand_sets;
+std::map<CACHE*, std::vector<history_entry>> history;
+std::map<CACHE*, champsim::optgen> optgen;
+
+std::map<CACHE*, std::vector<pchr_type>> pchr;
+std::map<CACHE*, std::vector<int8_t>> isvm_weights;
+std::map<CACHE*, champsim::packed_counters<RRPV_BITS>> rrpv;
+std::map<CACHE*, champsim::way_partition> cat_partition;
+std::map<CACHE*, champsim::owner_tracker> owners;
+std::map<CACHE*, champsim::presence_hints> presence;
+std::map<CACHE*, champsim::writeback_policy> writebacks;
+std::map<CACHE*, champsim::access_breakdown> breakdown;
+std::map<CACHE*, champsim::reuse_profiler> reuse;
+std::map<CACHE*, champsim::set_sampling> sampling;
+
+struct glider_stats {
+  uint64_t high_confidence = 0;
+  uint64_t low_confidence = 0;
+  uint64_t averse = 0;
+};
+std::map<CACHE*, glider_stats> stats;
+
+uint64_t hash_pc(uint64_t ip) { return ip ^ (ip >> 13) ^ (ip >> 29); }
+
+uint32_t get_isvm(uint32_t cpu, uint64_t ip, uint32_t type)
+{
+  auto key = (hash_pc(ip) << 1) | (access_type{type} == access_type::PREFETCH ? 1 : 0);
+  return static_cast<uint32_t>(cpu * ISVM_TABLE_SIZE + key % ISVM_TABLE_SIZE);
+}
+
+// Insert ip into the core's history as most recent, keeping each PC at most once
+void update_pchr(pchr_type& history, uint64_t ip)
+{
+  auto found = std::find(std::begin(history), std::end(history), ip);
+  if (found == std::end(history))
+    found = std::prev(std::end(history));
+  std::rotate(std::begin(history), found, std::next(found));
+  history.front() = ip;
+}
+
+feature_type get_features(const pchr_type& history)
+{
+  feature_type features;
+  std::transform(std::begin(history), std::end(history), std::begin(features), [](uint64_t ip) { return static_cast<uint8_t>(hash_pc(ip) % ISVM_WEIGHTS); });
+  return features;
+}
+
+int predict(CACHE* cache, uint32_t isvm, const feature_type& features)
+{
+  const auto* weights = ::isvm_weights[cache].data() + isvm * ISVM_WEIGHTS;
+  int sum = 0;
+  for (auto f : features)
+    sum += weights[f];
+  return sum;
+}
+
+void train(CACHE* cache, uint32_t isvm, const feature_type& features, bool friendly)
+{
+  auto sum = predict(cache, isvm, features);
+  if (friendly ? sum >= TRAIN_THRESHOLD : sum <= -TRAIN_THRESHOLD)
+    return;
+
+  auto* weights = ::isvm_weights[cache].data() + isvm * ISVM_WEIGHTS;
+  for (auto f : features)
+    weights[f] = static_cast<int8_t>(std::clamp(weights[f] + (friendly ? 1 : -1), -128, 127));
+}
+
+// Feed one access to a sampled set through OPTgen and train the ISVM of the previous access to the same block
+void sampler_access(CACHE* cache, std::size_t sample, uint64_t full_addr, uint32_t isvm, const feature_type& features)
+{
+  auto& opt = ::optgen.at(cache);
+  auto now = opt.access(sample);
+
+  auto block = full_addr >> LOG2_BLOCK_SIZE;
+  auto hist_begin = std::next(std::begin(::history[cache]), sample * HISTORY_MULT * cache->NUM_WAY);
+  auto hist_end = std::next(hist_begin, HISTORY_MULT * cache->NUM_WAY);
+  auto entry = std::find_if(hist_begin, hist_end, [block](const auto& x) { return x.valid && x.block == block; });
+
+  if (entry != hist_end) {
+    ::train(cache, entry->isvm, entry->features, opt.should_cache(sample, entry->last_access, now));
+  } else {
+    // replace the least recently accessed history entry; it was not reused within the history, which OPT would not cache
+    entry = std::min_element(hist_begin, hist_end, [](const auto& x, const auto& y) { return std::pair{x.valid, x.last_access} < std::pair{y.valid, y.last_access}; });
+    if (entry->valid)
+      ::train(cache, entry->isvm, entry->features, false);
+  }
+
+  *entry = {true, block, isvm, features, now};
+}
+
+// applies a batch of hits and fills, defined below and registered for each cache by initialize_replacement()
+void update_batch(CACHE* cache, const champsim::replacement_access* first, const champsim::replacement_access* last);
+} // namespace
+
+void CACHE::initialize_replacement()
+{
+  // randomly selected sampler sets
+  ::rand_sets.emplace(this, champsim::sampler_sets{NUM_SET, ::SAMPLER_SET});
+
+  auto sampled = ::rand_sets.at(this).size();
+  ::history[this] = std::vector<history_entry>(sampled * ::HISTORY_MULT * NUM_WAY);
+  ::optgen.emplace(this, champsim::optgen{sampled, NUM_WAY, ::OPTGEN_VECTOR_MULT * NUM_WAY});
+
+  ::pchr[this] = std::vector<pchr_type>(NUM_CPUS);
+  ::isvm_weights[this] = std::vector<int8_t>(NUM_CPUS * ::ISVM_TABLE_SIZE * ::ISVM_WEIGHTS);
+  ::rrpv.emplace(this, champsim::packed_counters<::RRPV_BITS>{NUM_SET, NUM_WAY, ::maxRRPV});
+  ::cat_partition.try_emplace(this, NAME, NUM_WAY);
+  ::owners.emplace(this, champsim::owner_tracker{NUM_SET, NUM_WAY});
+  ::presence.try_emplace(this, NAME, NUM_SET, NUM_WAY);
+  ::writebacks.emplace(this, champsim::writeback_policy{NUM_SET, NUM_WAY});
+  ::breakdown.emplace(this, champsim::access_breakdown{NAME, NUM_SET, NUM_WAY});
+  ::reuse.emplace(this, champsim::reuse_profiler{NUM_SET});
+  ::sampling.emplace(this, champsim::set_sampling{NUM_SET, NUM_WAY});
+  ::sampling.at(this).include(::rand_sets.at(this));
+
+  // for callers that batch their updates (see replacement_batch.h)
+  champsim::replacement_batches()[NAME] = [this](const champsim::replacement_access* first, const champsim::replacement_access* last) {
+    ::update_batch(this, first, last);
+  };
+}
+
+// find replacement victim
+uint32_t CACHE::find_victim(uint32_t triggering_cpu, uint64_t instr_id, uint32_t set, const BLOCK* current_set, uint64_t ip, uint64_t full_addr, uint32_t type)
+{
+  if (!::sampling.at(this).modeled(set))
+    return ::sampling.at(this).skipped_victim(set);
+
+  auto candidates = ::presence.at(this).filter(set, ::cat_partition.at(this).victim_mask(triggering_cpu));
+  candidates = ::writebacks.at(this).filter(set, candidates);
+  auto victim = champsim::rrip_find_victim(::rrpv.at(this), set, candidates);
+  assert(victim < NUM_WAY);
+  return static_cast<uint32_t>(victim); // cast protected by assertion
+}
+
+namespace
+{
+// called with runs of hits and fills to one set
+void update_batch(CACHE* cache, const champsim::replacement_access* first, const champsim::replacement_access* last)
+{
+  auto& rand_sets = ::rand_sets.at(cache);
+  auto& pchr = ::pchr[cache];
+  auto& stats = ::stats[cache];
+  auto& set_rrpv = ::rrpv.at(cache);
+  auto& owners = ::owners.at(cache);
+  auto& presence = ::presence.at(cache);
+  auto& writebacks = ::writebacks.at(cache);
+  auto& breakdown = ::breakdown.at(cache);
+  auto& reuse = ::reuse.at(cache);
+  auto& sampling = ::sampling.at(cache);
+
+  auto prefetch_set = [&](uint32_t set) { set_rrpv.prefetch_row(set); };
+
+  champsim::for_each_set_run(first, last, prefetch_set, [&](const champsim::set_run& run) {
+    if (!sampling.modeled(run.set()))
+      return;
+
+    // the set's OPTgen sample, if it is a sampled set
+    auto sample = rand_sets.index(run.set());
+
+    for (const auto& access : run) {
+      const auto& [triggering_cpu, set, way, full_addr, ip, victim_addr, type, hit] = access;
+      sampling.record(set, type, hit);
+      if (!hit)
+        owners.miss(triggering_cpu, set, way, full_addr, victim_addr);
+      presence.update(set, way, full_addr, type, hit);
+      writebacks.update(set, way, type, hit);
+      breakdown.update(triggering_cpu, set, way, type, hit);
+      reuse.access(triggering_cpu, set, full_addr, type);
+
+      if (writebacks.apply(type, hit, [&] { set_rrpv.set(access.set, access.way, ::maxRRPV); }, [&] { set_rrpv.set(access.set, access.way, 0); }))
+        continue;
+
+      // writebacks are not trained on and are inserted as cache-averse
+      if (access_type{type} == access_type::WRITE) {
+        if (!hit)
+          set_rrpv.set(set, way, ::maxRRPV);
+        continue;
+      }
+
+      auto& history = pchr[triggering_cpu];
+      ::update_pchr(history, ip);
+      auto features = ::get_features(history);
+      auto isvm = ::get_isvm(triggering_cpu, ip, type);
+
+      if (sample.has_value())
+        ::sampler_access(cache, *sample, full_addr, isvm, features);
+
+      auto sum = ::predict(cache, isvm, features);
+      if (sum >= ::HIGH_CONFIDENCE) {
+        set_rrpv.set(set, way, 0);
+        ++stats.high_confidence;
+      } else if (sum >= 0) {
+        set_rrpv.set(set, way, hit ? 0 : ::LOW_CONFIDENCE_RRPV);
+        ++stats.low_confidence;
+      } else {
+        set_rrpv.set(set, way, ::maxRRPV);
+        ++stats.averse;
+      }
+    }
+  });
+}
+} // namespace
+
+// called on every cache hit and cache fill
+void CACHE::update_replacement_state(uint32_t triggering_cpu, uint32_t set, uint32_t way, uint64_t full_addr, uint64_t ip, uint64_t victim_addr, uint32_t type,
+                                     uint8_t hit)
+{
+  champsim::replacement_access access{triggering_cpu, set, way, full_addr, ip, victim_addr, type, hit};
+  ::update_batch(this, &access, &access + 1);
+}
+
+// use this function to print out your own stats at the end of simulation
+void CACHE::replacement_final_stats()
+{
+  ::cat_partition.at(this).print();
+  ::owners.at(this).print(NAME);
+  ::presence.at(this).print();
+  ::writebacks.at(this).print(NAME);
+  ::breakdown.at(this).print();
+  ::reuse.at(this).print(NAME);
+  ::sampling.at(this).print(NAME);
+  const auto& opt = ::optgen.at(this);
+  const auto& s = ::stats[this];
+  std::cout << NAME << " GLIDER OPTGEN ACCESS: " << opt.accesses << " HIT: " << opt.hits;
+  std::cout << " HIT RATE: " << (opt.accesses > 0 ? static_cast<double>(opt.hits) / static_cast<double>(opt.accesses) : 0.0) << std::endl;
+  std::cout << NAME << " GLIDER HIGH CONFIDENCE: " << s.high_confidence << " LOW CONFIDENCE: " << s.low_confidence << " AVERSE: " << s.averse << std::endl;
+}
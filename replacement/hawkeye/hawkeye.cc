@@ -0,0 +1,258 @@
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "access_breakdown.h"
+#include "cache.h"
+#include "metadata_prefetch.h"
+#include "optgen.h"
+#include "owner_tracker.h"
+#include "packed_counters.h"
+#include "presence_hints.h"
+#include "replacement_batch.h"
+#include "reuse_profiler.h"
+#include "sampler_sets.h"
+#include "set_sampling.h"
+#include "way_partition.h"
+#include "writeback_policy.h"
+
+/*
+ * Hawkeye (Jain and Lin, ISCA 2016)
+ *
+ * OPTgen reconstructs Belady's decisions for the accesses to a few sampled sets. Each time a sampled block is reused, the
+ * occupancy vector tells whether OPT would have kept it for the whole interval; the outcome trains a PC-indexed predictor
+ * that classifies fills as cache-friendly or cache-averse. Friendly lines are inserted at RRPV 0, averse lines at maxRRPV.
+ */
+namespace
+{
+constexpr unsigned RRPV_BITS = 3;
+constexpr unsigned maxRRPV = champsim::packed_counters<RRPV_BITS>::maximum;
+constexpr std::size_t SAMPLER_SET = 64 * NUM_CPUS;
+constexpr std::size_t OPTGEN_VECTOR_MULT = 8;  // the OPTgen window covers 8x the associativity, in sampled-set accesses
+constexpr std::size_t HISTORY_MULT = 8;        // history entries per sampled set, as a multiple of the associativity
+constexpr std::size_t PREDICTOR_SIZE = 2048;   // per core
+constexpr unsigned PREDICTOR_BITS = 3;
+
+struct history_entry {
+  bool valid = false;
+  uint64_t block = 0;
+  uint32_t signature = 0;
+  uint64_t last_access = 0;
+};
+
+std::map<CACHE*, champsim::sampler_sets> rand_sets;
+std::map<CACHE*, std::vector<history_entry>> history;
+std::map<CACHE*, champsim::optgen> optgen;
+
+std::map<CACHE*, champsim::packed_counters<PREDICTOR_BITS>> predictor;
+std::map<CACHE*, champsim::packed_counters<RRPV_BITS>> rrpv;
+std::map<CACHE*, std::vector<uint32_t>> line_signature;
+std::map<CACHE*, champsim::way_partition> cat_partition;
+std::map<CACHE*, champsim::owner_tracker> owners;
+std::map<CACHE*, champsim::presence_hints> presence;
+std::map<CACHE*, champsim::writeback_policy> writebacks;
+std::map<CACHE*, champsim::access_breakdown> breakdown;
+std::map<CACHE*, champsim::reuse_profiler> reuse;
+std::map<CACHE*, champsim::set_sampling> sampling;
+
+struct hawkeye_stats {
+  uint64_t friendly_fill = 0;
+  uint64_t averse_fill = 0;
+  uint64_t friendly_evict = 0;
+};
+std::map<CACHE*, hawkeye_stats> stats;
+
+uint32_t get_signature(uint32_t cpu, uint64_t ip, uint32_t type)
+{
+  auto key = (ip << 1) | (access_type{type} == access_type::PREFETCH ? 1 : 0);
+  key ^= (key >> 17) ^ (key >> 31);
+  return static_cast<uint32_t>(cpu * PREDICTOR_SIZE + key % PREDICTOR_SIZE);
+}
+
+bool is_friendly(CACHE* cache, uint32_t signature) { return ::predictor.at(cache).get(0, signature) > (::predictor.at(cache).maximum >> 1); }
+
+// Feed one access to a sampled set through OPTgen and train the predictor on the previous access to the same block
+void optgen_access(CACHE* cache, std::size_t sample, uint64_t full_addr, uint32_t signature)
+{
+  auto& opt = ::optgen.at(cache);
+  auto& pred = ::predictor.at(cache);
+  auto now = opt.access(sample);
+
+  auto block = full_addr >> LOG2_BLOCK_SIZE;
+  auto hist_begin = std::next(std::begin(::history[cache]), sample * HISTORY_MULT * cache->NUM_WAY);
+  auto hist_end = std::next(hist_begin, HISTORY_MULT * cache->NUM_WAY);
+  auto entry = std::find_if(hist_begin, hist_end, [block](const auto& x) { return x.valid && x.block == block; });
+
+  if (entry != hist_end) {
+    if (opt.should_cache(sample, entry->last_access, now))
+      pred.increment(0, entry->signature);
+    else
+      pred.decrement(0, entry->signature);
+  } else {
+    // replace the least recently accessed history entry
+    entry = std::min_element(hist_begin, hist_end, [](const auto& x, const auto& y) { return std::pair{x.valid, x.last_access} < std::pair{y.valid, y.last_access}; });
+  }
+
+  *entry = {true, block, signature, now};
+}
+
+// applies a batch of hits and fills, defined below and registered for each cache by initialize_replacement()
+void update_batch(CACHE* cache, const champsim::replacement_access* first, const champsim::replacement_access* last);
+} // namespace
+
+void CACHE::initialize_replacement()
+{
+  // randomly selected sampler sets
+  ::rand_sets.emplace(this, champsim::sampler_sets{NUM_SET, ::SAMPLER_SET});
+
+  auto sampled = ::rand_sets.at(this).size();
+  ::history[this] = std::vector<history_entry>(sampled * ::HISTORY_MULT * NUM_WAY);
+  ::optgen.emplace(this, champsim::optgen{sampled, NUM_WAY, ::OPTGEN_VECTOR_MULT * NUM_WAY});
+
+  // predictor counters start weakly friendly
+  ::predictor.emplace(this, champsim::packed_counters<::PREDICTOR_BITS>{1, NUM_CPUS * ::PREDICTOR_SIZE, (champsim::packed_counters<::PREDICTOR_BITS>::maximum >> 1) + 1});
+  ::rrpv.emplace(this, champsim::packed_counters<::RRPV_BITS>{NUM_SET, NUM_WAY, ::maxRRPV});
+  ::line_signature[this] = std::vector<uint32_t>(NUM_SET * NUM_WAY);
+  ::cat_partition.try_emplace(this, NAME, NUM_WAY);
+  ::owners.emplace(this, champsim::owner_tracker{NUM_SET, NUM_WAY});
+  ::presence.try_emplace(this, NAME, NUM_SET, NUM_WAY);
+  ::writebacks.emplace(this, champsim::writeback_policy{NUM_SET, NUM_WAY});
+  ::breakdown.emplace(this, champsim::access_breakdown{NAME, NUM_SET, NUM_WAY});
+  ::reuse.emplace(this, champsim::reuse_profiler{NUM_SET});
+  ::sampling.emplace(this, champsim::set_sampling{NUM_SET, NUM_WAY});
+  ::sampling.at(this).include(::rand_sets.at(this));
+
+  // for callers that batch their updates (see replacement_batch.h)
+  champsim::replacement_batches()[NAME] = [this](const champsim::replacement_access* first, const champsim::replacement_access* last) {
+    ::update_batch(this, first, last);
+  };
+}
+
+// find replacement victim
+uint32_t CACHE::find_victim(uint32_t triggering_cpu, uint64_t instr_id, uint32_t set, const BLOCK* current_set, uint64_t ip, uint64_t full_addr, uint32_t type)
+{
+  if (!::sampling.at(this).modeled(set))
+    return ::sampling.at(this).skipped_victim(set);
+
+  auto& set_rrpv = ::rrpv.at(this);
+  auto candidates = ::presence.at(this).filter(set, ::cat_partition.at(this).victim_mask(triggering_cpu));
+  candidates = ::writebacks.at(this).filter(set, candidates);
+
+  // prefer a cache-averse line
+  auto victim = set_rrpv.find(set, ::maxRRPV, candidates);
+  if (victim == NUM_WAY) {
+    // otherwise evict the oldest cache-friendly line, and detrain the PC that inserted it
+    victim = set_rrpv.find(set, set_rrpv.row_max(set, candidates), candidates);
+    ::predictor.at(this).decrement(0, ::line_signature[this][set * NUM_WAY + victim]);
+    ++::stats[this].friendly_evict;
+  }
+
+  assert(victim < NUM_WAY);
+  return static_cast<uint32_t>(victim); // cast protected by assertion
+}
+
+namespace
+{
+// called with runs of hits and fills to one set
+void update_batch(CACHE* cache, const champsim::replacement_access* first, const champsim::replacement_access* last)
+{
+  auto& rand_sets = ::rand_sets.at(cache);
+  auto& line_signature = ::line_signature[cache];
+  auto& stats = ::stats[cache];
+  auto& set_rrpv = ::rrpv.at(cache);
+  auto& owners = ::owners.at(cache);
+  auto& presence = ::presence.at(cache);
+  auto& writebacks = ::writebacks.at(cache);
+  auto& breakdown = ::breakdown.at(cache);
+  auto& reuse = ::reuse.at(cache);
+  auto& sampling = ::sampling.at(cache);
+
+  auto prefetch_set = [&](uint32_t set) {
+    set_rrpv.prefetch_row(set);
+    champsim::prefetch_range(line_signature.data() + std::size_t{set} * cache->NUM_WAY, cache->NUM_WAY);
+  };
+
+  champsim::for_each_set_run(first, last, prefetch_set, [&](const champsim::set_run& run) {
+    if (!sampling.modeled(run.set()))
+      return;
+
+    auto set_signature = line_signature.data() + std::size_t{run.set()} * cache->NUM_WAY;
+
+    // the set's OPTgen sample, if it is a sampled set
+    auto sample = rand_sets.index(run.set());
+
+    for (const auto& access : run) {
+      const auto& [triggering_cpu, set, way, full_addr, ip, victim_addr, type, hit] = access;
+      sampling.record(set, type, hit);
+      if (!hit)
+        owners.miss(triggering_cpu, set, way, full_addr, victim_addr);
+      presence.update(set, way, full_addr, type, hit);
+      writebacks.update(set, way, type, hit);
+      breakdown.update(triggering_cpu, set, way, type, hit);
+      reuse.access(triggering_cpu, set, full_addr, type);
+
+      if (writebacks.apply(type, hit, [&] { set_rrpv.set(access.set, access.way, ::maxRRPV); }, [&] { set_rrpv.set(access.set, access.way, 0); }))
+        continue;
+
+      // writebacks are not trained on and are inserted as cache-averse
+      if (access_type{type} == access_type::WRITE) {
+        if (!hit)
+          set_rrpv.set(set, way, ::maxRRPV);
+        continue;
+      }
+
+      auto signature = ::get_signature(triggering_cpu, ip, type);
+      if (sample.has_value())
+        ::optgen_access(cache, *sample, full_addr, signature);
+
+      set_signature[way] = signature;
+
+      if (!::is_friendly(cache, signature)) {
+        set_rrpv.set(set, way, ::maxRRPV);
+        if (!hit)
+          ++stats.averse_fill;
+        continue;
+      }
+
+      if (!hit) {
+        // age the other cache-friendly lines, without letting them become cache-averse
+        for (uint32_t i = 0; i < cache->NUM_WAY; ++i) {
+          if (i != way && set_rrpv.get(set, i) < ::maxRRPV - 1)
+            set_rrpv.increment(set, i);
+        }
+        ++stats.friendly_fill;
+      }
+      set_rrpv.set(set, way, 0);
+    }
+  });
+}
+} // namespace
+
+// called on every cache hit and cache fill
+void CACHE::update_replacement_state(uint32_t triggering_cpu, uint32_t set, uint32_t way, uint64_t full_addr, uint64_t ip, uint64_t victim_addr, uint32_t type,
+                                     uint8_t hit)
+{
+  champsim::replacement_access access{triggering_cpu, set, way, full_addr, ip, victim_addr, type, hit};
+  ::update_batch(this, &access, &access + 1);
+}
+
+// use this function to print out your own stats at the end of simulation
+void CACHE::replacement_final_stats()
+{
+  ::cat_partition.at(this).print();
+  ::owners.at(this).print(NAME);
+  ::presence.at(this).print();
+  ::writebacks.at(this).print(NAME);
+  ::breakdown.at(this).print();
+  ::reuse.at(this).print(NAME);
+  ::sampling.at(this).print(NAME);
+  const auto& opt = ::optgen.at(this);
+  const auto& s = ::stats[this];
+  std::cout << NAME << " HAWKEYE OPTGEN ACCESS: " << opt.accesses << " HIT: " << opt.hits;
+  std::cout << " HIT RATE: " << (opt.accesses > 0 ? static_cast<double>(opt.hits) / static_cast<double>(opt.accesses) : 0.0) << std::endl;
+  std::cout << NAME << " HAWKEYE FRIENDLY FILL: " << s.friendly_fill << " AVERSE FILL: " << s.averse_fill << " FRIENDLY EVICT: " << s.friendly_evict << std::endl;
+}
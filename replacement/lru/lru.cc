@@ -1,35 +1,157 @@
 #include <algorithm>
 #include <cassert>
+#include <iostream>
 #include <map>
 #include <vector>
 
+#include "access_breakdown.h"
 #include "cache.h"
+#include "metadata_prefetch.h"
+#include "owner_tracker.h"
+#include "presence_hints.h"
+#include "replacement_batch.h"
+#include "reuse_profiler.h"
+#include "set_sampling.h"
+#include "way_mask.h"
+#include "way_partition.h"
+#include "writeback_policy.h"
+
+#ifdef UCP_PARTITION
+#include "ucp.h"
+#endif
 
 namespace
 {
 std::map<CACHE*, std::vector<uint64_t>> last_used_cycles;
-}
+std::map<CACHE*, champsim::way_partition> cat_partition;
+std::map<CACHE*, champsim::owner_tracker> owners;
+std::map<CACHE*, champsim::presence_hints> presence;
+std::map<CACHE*, champsim::writeback_policy> writebacks;
+std::map<CACHE*, champsim::access_breakdown> breakdown;
+std::map<CACHE*, champsim::reuse_profiler> reuse;
+std::map<CACHE*, champsim::set_sampling> sampling;
+
+#ifdef UCP_PARTITION
+std::map<CACHE*, champsim::ucp> partition;
+#endif
+
+// applies a batch of hits and fills, defined below and registered for each cache by initialize_replacement()
+void update_batch(CACHE* cache, const champsim::replacement_access* first, const champsim::replacement_access* last);
+} // namespace
+
+void CACHE::initialize_replacement()
+{
+  ::last_used_cycles[this] = std::vector<uint64_t>(NUM_SET * NUM_WAY);
+  ::cat_partition.try_emplace(this, NAME, NUM_WAY);
+  ::owners.emplace(this, champsim::owner_tracker{NUM_SET, NUM_WAY});
+  ::presence.try_emplace(this, NAME, NUM_SET, NUM_WAY);
+  ::writebacks.emplace(this, champsim::writeback_policy{NUM_SET, NUM_WAY});
+  ::breakdown.emplace(this, champsim::access_breakdown{NAME, NUM_SET, NUM_WAY});
+  ::reuse.emplace(this, champsim::reuse_profiler{NUM_SET});
+  ::sampling.emplace(this, champsim::set_sampling{NUM_SET, NUM_WAY});
+#ifdef UCP_PARTITION
+  ::partition.emplace(this, champsim::ucp{NUM_SET, NUM_WAY});
+#endif
 
-void CACHE::initialize_replacement() { ::last_used_cycles[this] = std::vector<uint64_t>(NUM_SET * NUM_WAY); }
+  // for callers that batch their updates (see replacement_batch.h)
+  champsim::replacement_batches()[NAME] = [this](const champsim::replacement_access* first, const champsim::replacement_access* last) {
+    ::update_batch(this, first, last);
+  };
+}
 
 uint32_t CACHE::find_victim(uint32_t triggering_cpu, uint64_t instr_id, uint32_t set, const BLOCK* current_set, uint64_t ip, uint64_t full_addr, uint32_t type)
 {
+  if (!::sampling.at(this).modeled(set))
+    return ::sampling.at(this).skipped_victim(set);
+
   auto begin = std::next(std::begin(::last_used_cycles[this]), set * NUM_WAY);
   auto end = std::next(begin, NUM_WAY);
 
+  auto candidates = ::cat_partition.at(this).victim_mask(triggering_cpu);
+#ifdef UCP_PARTITION
+  if (auto ucp_candidates = candidates & ::partition.at(this).victim_mask(triggering_cpu, set, ::owners.at(this)); ucp_candidates != 0)
+    candidates = ucp_candidates;
+#endif
+  candidates = ::presence.at(this).filter(set, candidates);
+  candidates = ::writebacks.at(this).filter(set, candidates);
+
   // Find the way whose last use cycle is most distant
-  auto victim = std::min_element(begin, end);
+  auto victim = champsim::masked_min_element(begin, end, candidates);
   assert(begin <= victim);
   assert(victim < end);
   return static_cast<uint32_t>(std::distance(begin, victim)); // cast protected by prior asserts
 }
 
+namespace
+{
+// called with runs of hits and fills to one set
+void update_batch(CACHE* cache, const champsim::replacement_access* first, const champsim::replacement_access* last)
+{
+  auto& last_used_cycles = ::last_used_cycles[cache];
+  auto& owners = ::owners.at(cache);
+  auto& presence = ::presence.at(cache);
+  auto& writebacks = ::writebacks.at(cache);
+  auto& breakdown = ::breakdown.at(cache);
+  auto& reuse = ::reuse.at(cache);
+  auto& sampling = ::sampling.at(cache);
+#ifdef UCP_PARTITION
+  auto& partition = ::partition.at(cache);
+#endif
+
+  auto prefetch_set = [&](uint32_t set) { champsim::prefetch_range(last_used_cycles.data() + std::size_t{set} * cache->NUM_WAY, cache->NUM_WAY); };
+
+  champsim::for_each_set_run(first, last, prefetch_set, [&](const champsim::set_run& run) {
+    if (!sampling.modeled(run.set()))
+      return;
+
+    auto set_last_used = last_used_cycles.data() + std::size_t{run.set()} * cache->NUM_WAY;
+
+    for (const auto& [triggering_cpu, set, way, full_addr, ip, victim_addr, type, hit] : run) {
+      sampling.record(set, type, hit);
+#ifdef UCP_PARTITION
+      if (access_type{type} != access_type::WRITE)
+        partition.access(triggering_cpu, set, full_addr);
+#endif
+      if (!hit)
+        owners.miss(triggering_cpu, set, way, full_addr, victim_addr);
+      presence.update(set, way, full_addr, type, hit);
+      writebacks.update(set, way, type, hit);
+      breakdown.update(triggering_cpu, set, way, type, hit);
+      reuse.access(triggering_cpu, set, full_addr, type);
+
+      // The fill was bypassed, there is no line to update
+      if (way == cache->NUM_WAY)
+        continue;
+
+      auto& last_used = set_last_used[way];
+      if (writebacks.apply(type, hit, [&] { last_used = 0; }, [&] { last_used = cache->current_cycle; }))
+        continue;
+
+      // Mark the way as being used on the current cycle
+      if (!hit || access_type{type} != access_type::WRITE) // Skip this for writeback hits
+        last_used = cache->current_cycle;
+    }
+  });
+}
+} // namespace
+
 void CACHE::update_replacement_state(uint32_t triggering_cpu, uint32_t set, uint32_t way, uint64_t full_addr, uint64_t ip, uint64_t victim_addr, uint32_t type,
                                      uint8_t hit)
 {
-  // Mark the way as being used on the current cycle
-  if (!hit || access_type{type} != access_type::WRITE) // Skip this for writeback hits
-    ::last_used_cycles[this].at(set * NUM_WAY + way) = current_cycle;
+  champsim::replacement_access access{triggering_cpu, set, way, full_addr, ip, victim_addr, type, hit};
+  ::update_batch(this, &access, &access + 1);
 }
 
-void CACHE::replacement_final_stats() {}
+void CACHE::replacement_final_stats()
+{
+  ::cat_partition.at(this).print();
+  ::owners.at(this).print(NAME);
+  ::presence.at(this).print();
+  ::writebacks.at(this).print(NAME);
+  ::breakdown.at(this).print();
+  ::reuse.at(this).print(NAME);
+  ::sampling.at(this).print(NAME);
+#ifdef UCP_PARTITION
+  ::partition.at(this).print(NAME);
+#endif
+}
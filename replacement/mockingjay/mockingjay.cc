@@ -0,0 +1,282 @@
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "access_breakdown.h"
+#include "bypass_monitor.h"
+#include "cache.h"
+#include "owner_tracker.h"
+#include "packed_counters.h"
+#include "presence_hints.h"
+#include "replacement_batch.h"
+#include "reuse_profiler.h"
+#include "sampler_sets.h"
+#include "set_sampling.h"
+#include "way_partition.h"
+#include "writeback_policy.h"
+
+/*
+ * Mockingjay (Shah, Jain and Lin, HPCA 2022)
+ *
+ * A PC-indexed reuse distance predictor (RDP) is trained on a small sampled cache that records, for a few sets, when each
+ * block was last touched. Every line carries an estimated time of arrival (ETA): its predicted reuse distance in units of
+ * GRANULARITY set accesses, counted down as its set is accessed and going negative once the line is overdue. The victim is
+ * the line whose ETA is furthest from now in either direction, so a line long past its predicted reuse is also evicted.
+ *
+ * ETAs are stored biased by ETA_ZERO in small unsigned counters, so ageing a set is a saturating decrement of the whole row
+ * and the victim is found from the row's maximum and minimum.
+ */
+namespace
+{
+constexpr unsigned ETA_BITS = 5;
+constexpr unsigned ETA_ZERO = 8;                                            // stored value of a line predicted to be reused now
+constexpr unsigned INF_ETA = champsim::packed_counters<ETA_BITS>::maximum; // stored value of a line predicted not to be reused
+constexpr unsigned GRANULARITY = 8;                                         // set accesses per ETA tick
+constexpr unsigned INF_RD = (INF_ETA - ETA_ZERO) * GRANULARITY;             // reuse distances at or beyond this are infinite
+constexpr std::size_t SAMPLER_SET = 32 * NUM_CPUS;
+constexpr std::size_t SAMPLED_CACHE_MULT = 5; // sampled cache entries per sampled set, as a multiple of the associativity
+constexpr std::size_t RDP_SIZE = 2048;        // per core
+constexpr int TEMPORAL_DIFFERENCE = 16;       // the RDP moves 1/TEMPORAL_DIFFERENCE of the way to each observation
+constexpr uint16_t RDP_UNTRAINED = 0xffff;
+
+struct sampled_entry {
+  bool valid = false;
+  uint64_t block = 0;
+  uint32_t signature = 0;
+  uint64_t timestamp = 0;
+};
+
+std::map<CACHE*, champsim::sampler_sets> rand_sets;
+std::map<CACHE*, std::vector<uint64_t>> sampler_timer;
+std::map<CACHE*, std::vector<sampled_entry>> sampled_cache;
+
+std::map<CACHE*, std::vector<uint16_t>> rdp;
+std::map<CACHE*, champsim::packed_counters<ETA_BITS>> eta;
+std::map<CACHE*, std::vector<uint8_t>> set_clock;
+std::map<CACHE*, champsim::bypass_monitor<>> bypass_stats;
+std::map<CACHE*, champsim::way_partition> cat_partition;
+std::map<CACHE*, champsim::owner_tracker> owners;
+std::map<CACHE*, champsim::presence_hints> presence;
+std::map<CACHE*, champsim::writeback_policy> writebacks;
+std::map<CACHE*, champsim::access_breakdown> breakdown;
+std::map<CACHE*, champsim::reuse_profiler> reuse;
+std::map<CACHE*, champsim::set_sampling> sampling;
+
+struct mockingjay_stats {
+  uint64_t train_reuse = 0;
+  uint64_t train_inf = 0;
+};
+std::map<CACHE*, mockingjay_stats> stats;
+
+uint32_t get_signature(uint32_t cpu, uint64_t ip, uint32_t type)
+{
+  auto key = (ip << 1) | (access_type{type} == access_type::PREFETCH ? 1 : 0);
+  key ^= (key >> 17) ^ (key >> 31);
+  return static_cast<uint32_t>(cpu * RDP_SIZE + key % RDP_SIZE);
+}
+
+void train(CACHE* cache, uint32_t signature, unsigned observed)
+{
+  auto& prediction = ::rdp[cache][signature];
+  if (prediction == RDP_UNTRAINED) {
+    prediction = static_cast<uint16_t>(observed);
+    return;
+  }
+
+  int diff = static_cast<int>(observed) - static_cast<int>(prediction);
+  int step = diff / TEMPORAL_DIFFERENCE;
+  if (step == 0)
+    step = (diff > 0) - (diff < 0);
+  prediction = static_cast<uint16_t>(std::clamp<int>(prediction + step, 0, INF_RD));
+}
+
+// Biased ETA for a line inserted or promoted by this signature
+unsigned predicted_eta(CACHE* cache, uint32_t signature)
+{
+  auto prediction = ::rdp[cache][signature];
+  if (prediction == RDP_UNTRAINED)
+    return ETA_ZERO + cache->NUM_WAY / GRANULARITY; // behave like LRU until trained
+  return std::min<unsigned>(ETA_ZERO + prediction / GRANULARITY, INF_ETA);
+}
+
+// Record an access to a sampled set and train the RDP with the observed reuse distance
+void sampler_access(CACHE* cache, std::size_t sample, uint64_t full_addr, uint32_t signature)
+{
+  auto ways = SAMPLED_CACHE_MULT * cache->NUM_WAY;
+  auto now = ::sampler_timer[cache][sample]++;
+  auto block = full_addr >> LOG2_BLOCK_SIZE;
+
+  auto begin = std::next(std::begin(::sampled_cache[cache]), sample * ways);
+  auto end = std::next(begin, ways);
+  auto entry = std::find_if(begin, end, [block](const auto& x) { return x.valid && x.block == block; });
+
+  if (entry != end) {
+    ::train(cache, entry->signature, static_cast<unsigned>(std::min<uint64_t>(now - entry->timestamp, INF_RD)));
+    ++::stats[cache].train_reuse;
+  } else {
+    // the oldest entry was not reused while it was sampled
+    entry = std::min_element(begin, end, [](const auto& x, const auto& y) { return std::pair{x.valid, x.timestamp} < std::pair{y.valid, y.timestamp}; });
+    if (entry->valid) {
+      ::train(cache, entry->signature, INF_RD);
+      ++::stats[cache].train_inf;
+    }
+  }
+
+  *entry = {true, block, signature, now};
+}
+
+// applies a batch of hits and fills, defined below and registered for each cache by initialize_replacement()
+void update_batch(CACHE* cache, const champsim::replacement_access* first, const champsim::replacement_access* last);
+} // namespace
+
+void CACHE::initialize_replacement()
+{
+  // randomly selected sampler sets
+  ::rand_sets.emplace(this, champsim::sampler_sets{NUM_SET, ::SAMPLER_SET});
+
+  auto sampled = ::rand_sets.at(this).size();
+  ::sampler_timer[this] = std::vector<uint64_t>(sampled);
+  ::sampled_cache[this] = std::vector<sampled_entry>(sampled * ::SAMPLED_CACHE_MULT * NUM_WAY);
+
+  ::rdp[this] = std::vector<uint16_t>(NUM_CPUS * ::RDP_SIZE, ::RDP_UNTRAINED);
+  ::eta.emplace(this, champsim::packed_counters<::ETA_BITS>{NUM_SET, NUM_WAY, ::INF_ETA});
+  ::cat_partition.try_emplace(this, NAME, NUM_WAY);
+  ::owners.emplace(this, champsim::owner_tracker{NUM_SET, NUM_WAY});
+  ::presence.try_emplace(this, NAME, NUM_SET, NUM_WAY);
+  ::writebacks.emplace(this, champsim::writeback_policy{NUM_SET, NUM_WAY});
+  ::breakdown.emplace(this, champsim::access_breakdown{NAME, NUM_SET, NUM_WAY});
+  ::reuse.emplace(this, champsim::reuse_profiler{NUM_SET});
+  ::sampling.emplace(this, champsim::set_sampling{NUM_SET, NUM_WAY});
+  ::sampling.at(this).include(::rand_sets.at(this));
+  ::set_clock[this] = std::vector<uint8_t>(NUM_SET);
+
+  // for callers that batch their updates (see replacement_batch.h)
+  champsim::replacement_batches()[NAME] = [this](const champsim::replacement_access* first, const champsim::replacement_access* last) {
+    ::update_batch(this, first, last);
+  };
+}
+
+// find replacement victim
+uint32_t CACHE::find_victim(uint32_t triggering_cpu, uint64_t instr_id, uint32_t set, const BLOCK* current_set, uint64_t ip, uint64_t full_addr, uint32_t type)
+{
+  if (!::sampling.at(this).modeled(set))
+    return ::sampling.at(this).skipped_victim(set);
+
+  auto& set_eta = ::eta.at(this);
+  auto candidates = ::presence.at(this).filter(set, ::cat_partition.at(this).victim_mask(triggering_cpu));
+  candidates = ::writebacks.at(this).filter(set, candidates);
+
+  // the furthest ETA is either the latest predicted reuse or the most overdue one
+  auto latest = set_eta.row_max(set, candidates);
+  auto earliest = set_eta.row_min(set, candidates);
+  auto future = latest > ::ETA_ZERO ? latest - ::ETA_ZERO : 0;
+  auto overdue = earliest < ::ETA_ZERO ? ::ETA_ZERO - earliest : 0;
+
+#ifdef LLC_BYPASS
+  // bypass if the incoming block would be reused later than every resident line
+  if (access_type{type} != access_type::WRITE && ::predicted_eta(this, ::get_signature(triggering_cpu, ip, type)) - ::ETA_ZERO > std::max(future, overdue)) {
+    ::bypass_stats[this].record_bypass(full_addr, ip, type);
+    return NUM_WAY;
+  }
+#endif
+
+  auto victim = set_eta.find(set, overdue > future ? earliest : latest, candidates);
+  assert(victim < NUM_WAY);
+  return static_cast<uint32_t>(victim); // cast protected by assertion
+}
+
+namespace
+{
+// called with runs of hits and fills to one set
+void update_batch(CACHE* cache, const champsim::replacement_access* first, const champsim::replacement_access* last)
+{
+  auto& rand_sets = ::rand_sets.at(cache);
+  auto& set_clock = ::set_clock[cache];
+  auto& bypass_stats = ::bypass_stats[cache];
+  auto& set_eta = ::eta.at(cache);
+  auto& owners = ::owners.at(cache);
+  auto& presence = ::presence.at(cache);
+  auto& writebacks = ::writebacks.at(cache);
+  auto& breakdown = ::breakdown.at(cache);
+  auto& reuse = ::reuse.at(cache);
+  auto& sampling = ::sampling.at(cache);
+
+  auto prefetch_set = [&](uint32_t set) { set_eta.prefetch_row(set); };
+
+  champsim::for_each_set_run(first, last, prefetch_set, [&](const champsim::set_run& run) {
+    if (!sampling.modeled(run.set()))
+      return;
+
+    auto& clock = set_clock[run.set()];
+
+    // the set's sampler, if it is a sampled set
+    auto sample = rand_sets.index(run.set());
+
+    for (const auto& access : run) {
+      const auto& [triggering_cpu, set, way, full_addr, ip, victim_addr, type, hit] = access;
+      sampling.record(set, type, hit);
+      if (!hit)
+        owners.miss(triggering_cpu, set, way, full_addr, victim_addr);
+      presence.update(set, way, full_addr, type, hit);
+      writebacks.update(set, way, type, hit);
+      breakdown.update(triggering_cpu, set, way, type, hit);
+      reuse.access(triggering_cpu, set, full_addr, type);
+
+      // writebacks are not trained on and are inserted as never reused
+      if (access_type{type} == access_type::WRITE) {
+        if (way < cache->NUM_WAY
+            && !writebacks.apply(type, hit, [&] { set_eta.set(access.set, access.way, ::INF_ETA); }, [&] { set_eta.set(access.set, access.way, ::ETA_ZERO); }) && !hit)
+          set_eta.set(set, way, ::INF_ETA);
+        continue;
+      }
+
+      auto signature = ::get_signature(triggering_cpu, ip, type);
+      if (sample.has_value())
+        ::sampler_access(cache, *sample, full_addr, signature);
+
+      // age the set by one tick every GRANULARITY accesses
+      if (++clock == ::GRANULARITY) {
+        clock = 0;
+        set_eta.decrement_row(set);
+      }
+
+      // the fill was bypassed, there is no line to update
+      if (way == cache->NUM_WAY)
+        continue;
+
+      if (!hit) {
+        bypass_stats.record_fill();
+        bypass_stats.check_miss(full_addr);
+      }
+
+      set_eta.set(set, way, ::predicted_eta(cache, signature));
+    }
+  });
+}
+} // namespace
+
+// called on every cache hit and cache fill
+void CACHE::update_replacement_state(uint32_t triggering_cpu, uint32_t set, uint32_t way, uint64_t full_addr, uint64_t ip, uint64_t victim_addr, uint32_t type,
+                                     uint8_t hit)
+{
+  champsim::replacement_access access{triggering_cpu, set, way, full_addr, ip, victim_addr, type, hit};
+  ::update_batch(this, &access, &access + 1);
+}
+
+// use this function to print out your own stats at the end of simulation
+void CACHE::replacement_final_stats()
+{
+  ::cat_partition.at(this).print();
+  ::owners.at(this).print(NAME);
+  ::presence.at(this).print();
+  ::writebacks.at(this).print(NAME);
+  ::breakdown.at(this).print();
+  ::reuse.at(this).print(NAME);
+  ::sampling.at(this).print(NAME);
+  ::bypass_stats[this].print(NAME);
+  std::cout << NAME << " MOCKINGJAY RDP TRAIN REUSE: " << ::stats[this].train_reuse << " TRAIN INF: " << ::stats[this].train_inf << std::endl;
+}
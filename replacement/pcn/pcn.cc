@@ -1,72 +1,577 @@
 #include <map>
 #include <vector>
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "access_breakdown.h"
+#include "bypass_monitor.h"
+#include "cache.h"
+#include "metadata_prefetch.h"
+#include "owner_tracker.h"
+#include "pc_profile.h"
+#include "presence_hints.h"
+#include "replacement_batch.h"
+#include "reuse_profiler.h"
+#include "sampler_sets.h"
+#include "set_sampling.h"
+#include "training_pipeline.h"
+#include "way_mask.h"
+#include "way_partition.h"
+#include "writeback_policy.h"
+
+#ifdef DEAD_BLOCK_SCORING
+#include "dead_block_score.h"
+#endif
 
 namespace {
-    // Map to store perceptron weights for each cache set and way
-    std::map<CACHE*, std::vector<std::vector<int>>> perceptron_weights;
+    const int FEATURE_COUNT = 3; // Number of features (e.g., access_type, recency, frequency)
+
+    // Map to store perceptron weights for each cache set and way, one row per line so that a set's weights are contiguous
+    std::map<CACHE*, std::vector<std::array<int, FEATURE_COUNT>>> perceptron_weights;
+
+    // Cycle of the last access to each cache set and way (recency feature)
+    std::map<CACHE*, std::vector<uint64_t>> last_used_cycles;
 
     // Access type feature encoding
     const std::map<access_type, int> access_type_encoding = {
         {access_type::LOAD, 1},
+        {access_type::RFO, 1},
         {access_type::WRITE, 2},
-        {access_type::PREFETCH, -1}
+        {access_type::PREFETCH, -1},
+        {access_type::TRANSLATION, 1}
     };
 
-    // Threshold for perceptron eviction decisions
-    const int THRESHOLD = 10;
-    const int FEATURE_COUNT = 3; // Number of features (e.g., access_type, recency, frequency)
+    // Recency is the log2 bucket of a line's age in cycles, saturated at RECENCY_MAX_BUCKET. Unlike the raw cycle delta it
+    // cannot overflow over long simulations and stays on the same scale as the weights.
+    const int RECENCY_MAX_BUCKET = 31;
+
+    int recency_bucket(uint64_t age) {
+        // floor(log2(age)), with ages 0 and 1 both in bucket 0; no branches beyond the saturating min
+        return std::min(63 - __builtin_clzll(age | 1), RECENCY_MAX_BUCKET);
+    }
+
+    // Feature vector: {access_type, recency, frequency}
+    std::array<int, FEATURE_COUNT> make_features(uint32_t type, uint64_t age) {
+        return {
+            access_type_encoding.at(static_cast<access_type>(type)),
+            recency_bucket(age),
+            1 // Placeholder for frequency if applicable
+        };
+    }
+
+    // Weights are signed WEIGHT_BITS-wide saturating counters
+    const int WEIGHT_BITS = 5;
+    const int WEIGHT_MAX = (1 << (WEIGHT_BITS - 1)) - 1;
+    const int WEIGHT_MIN = -(1 << (WEIGHT_BITS - 1));
+    const int LEARNING_RATE = 1; // Step applied per training event, in the direction of each feature's sign
+
+    // Training threshold: the perceptron is trained only on a misprediction or when |output| <= theta. Theta adapts from
+    // the ratio of mispredictions to correct-but-low-confidence outputs (dynamic threshold fitting, as in O-GEHL).
+    const int THETA_INITIAL = 10;
+    const int THETA_MIN = 1;
+    const int THETA_MAX = FEATURE_COUNT * WEIGHT_MAX;
+    const int THETA_COUNTER_MAX = 31;
+
+    struct theta_state {
+        int theta = THETA_INITIAL;
+        int counter = 0;
+        uint64_t updates = 0;
+        uint64_t mispredictions = 0;
+        uint64_t low_confidence = 0;
+    };
+
+    std::map<CACHE*, theta_state> training;
+
+    // Dead-on-arrival predictor: hashed PC features, trained when a filled line is reused or evicted untouched
+    const std::size_t DOA_TABLE_SIZE = 4096;
+    const int DOA_FEATURE_COUNT = 2; // ip, ip combined with access type
+    const int BYPASS_THRESHOLD = DOA_FEATURE_COUNT * WEIGHT_MAX * 3 / 4; // sum of DOA weights at or below -BYPASS_THRESHOLD bypasses the fill
+    const std::size_t DOA_TRAINING_SETS = 32 * NUM_CPUS; // sets that never bypass, so a wrongly bypassed IP still sees its fills reused
+
+    // Only bypassing and dead block scoring read the predictor; without them it is not trained (its tables stay as loaded)
+#if defined(LLC_BYPASS) || defined(DEAD_BLOCK_SCORING)
+    constexpr bool DOA_PREDICTOR = true;
+#else
+    constexpr bool DOA_PREDICTOR = false;
+#endif
+
+    struct doa_line {
+        bool valid = false;
+        bool reused = false;
+        uint64_t ip = 0;
+        uint32_t type = 0;
+    };
+
+    std::map<CACHE*, std::vector<std::vector<int>>> doa_weights;
+    std::map<CACHE*, std::vector<doa_line>> doa_lines;
+    std::map<CACHE*, champsim::bypass_monitor<>> bypass_stats;
+    std::map<CACHE*, champsim::sampler_sets> training_sets;
+    std::map<CACHE*, champsim::way_partition> cat_partition;
+    std::map<CACHE*, champsim::owner_tracker> owners;
+    std::map<CACHE*, champsim::presence_hints> presence;
+    std::map<CACHE*, champsim::writeback_policy> writebacks;
+    std::map<CACHE*, champsim::access_breakdown> breakdown;
+    std::map<CACHE*, champsim::reuse_profiler> reuse;
+    std::map<CACHE*, champsim::set_sampling> sampling;
+    std::map<CACHE*, champsim::pc_profile<>> top_pcs;
+#ifdef DEAD_BLOCK_SCORING
+    std::map<CACHE*, champsim::dead_block_score> scoring;
+#endif
+
+    std::size_t doa_index(int feature, uint64_t ip, uint32_t type) {
+        uint64_t key = (feature == 0) ? ip : (ip ^ (static_cast<uint64_t>(type) << 20));
+        return static_cast<std::size_t>((key ^ (key >> 12) ^ (key >> 24)) % DOA_TABLE_SIZE);
+    }
+
+    // Offline weight files. Set PCN_WEIGHTS_OUT to dump the trained tables at the end of a run and PCN_WEIGHTS_IN to warm
+    // start from them; both paths get ".<cache name>" appended. Training over a corpus of traces is a sequence of runs that
+    // read and write the same file. PCN_FROZEN=1 (or true) loads the tables and skips all training (inference only); any
+    // other value, including an empty one, leaves training on.
+    const char* WEIGHTS_IN_ENV = "PCN_WEIGHTS_IN";
+    const char* WEIGHTS_OUT_ENV = "PCN_WEIGHTS_OUT";
+    const char* FROZEN_ENV = "PCN_FROZEN";
+
+    const char WEIGHT_FILE_MAGIC[4] = {'P', 'C', 'N', 'W'};
+    const uint32_t WEIGHT_FILE_VERSION = 1;
+
+    struct weight_file_header {
+        char magic[4];
+        uint32_t version;
+        uint32_t num_set;
+        uint32_t num_way;
+        uint32_t feature_count;
+        uint32_t doa_feature_count;
+        uint32_t doa_table_size;
+        uint32_t reserved;
+    };
+
+    std::map<CACHE*, bool> frozen;
+
+    std::string weight_file_path(const char* env, const std::string& cache_name) {
+        const char* path = std::getenv(env);
+        if (path == nullptr || *path == '\0')
+            return {};
+        return std::string{path} + "." + cache_name;
+    }
+
+    weight_file_header make_header(uint32_t num_set, uint32_t num_way) {
+        weight_file_header header{};
+        std::memcpy(header.magic, WEIGHT_FILE_MAGIC, sizeof(header.magic));
+        header.version = WEIGHT_FILE_VERSION;
+        header.num_set = num_set;
+        header.num_way = num_way;
+        header.feature_count = FEATURE_COUNT;
+        header.doa_feature_count = DOA_FEATURE_COUNT;
+        header.doa_table_size = DOA_TABLE_SIZE;
+        return header;
+    }
+
+    // Map a weight file and copy its tables in. Returns false (leaving the tables cold) if the file is missing or was
+    // written for a different cache geometry or file version.
+    bool load_weights(CACHE* cache, const std::string& path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat st;
+        auto expected = make_header(cache->NUM_SET, cache->NUM_WAY);
+        std::size_t line_count = std::size_t{cache->NUM_SET} * cache->NUM_WAY;
+        std::size_t expected_size = sizeof(weight_file_header) + sizeof(int32_t) * (line_count * FEATURE_COUNT + DOA_FEATURE_COUNT * DOA_TABLE_SIZE);
+        if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) != expected_size) {
+            close(fd);
+            return false;
+        }
+
+        void* mapping = mmap(nullptr, expected_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED)
+            return false;
+
+        weight_file_header header;
+        std::memcpy(&header, mapping, sizeof(header));
+        bool match = std::memcmp(&header, &expected, sizeof(header)) == 0;
+        if (match) {
+            auto values = reinterpret_cast<const int32_t*>(static_cast<const char*>(mapping) + sizeof(weight_file_header));
+            // Files written with a wider weight width are saturated to the current one
+            auto clamp_weight = [](int32_t w) { return std::clamp<int>(w, WEIGHT_MIN, WEIGHT_MAX); };
+            for (auto& weights : perceptron_weights[cache]) {
+                std::transform(values, values + FEATURE_COUNT, weights.begin(), clamp_weight);
+                values += FEATURE_COUNT;
+            }
+            for (auto& table : doa_weights[cache]) {
+                std::transform(values, values + DOA_TABLE_SIZE, table.begin(), clamp_weight);
+                values += DOA_TABLE_SIZE;
+            }
+        }
+
+        munmap(mapping, expected_size);
+        return match;
+    }
+
+    void save_weights(CACHE* cache, const std::string& path) {
+        std::ofstream out{path, std::ios::binary | std::ios::trunc};
+        auto header = make_header(cache->NUM_SET, cache->NUM_WAY);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        auto write_values = [&out](const auto& weights) {
+            std::vector<int32_t> values(weights.begin(), weights.end());
+            out.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(sizeof(int32_t) * values.size()));
+        };
+        for (const auto& weights : perceptron_weights[cache])
+            write_values(weights);
+        for (const auto& table : doa_weights[cache])
+            write_values(table);
+
+        if (!out)
+            std::cerr << cache->NAME << " PCN: failed to write weights to " << path << std::endl;
+    }
+
+    // Inference reads the weights with shared_load(): with PCN_TRAINING=async they are trained on a helper thread
+#if defined(LLC_BYPASS) || defined(DEAD_BLOCK_SCORING)
+    int doa_score(CACHE* cache, uint64_t ip, uint32_t type) {
+        int score = 0;
+        for (int i = 0; i < DOA_FEATURE_COUNT; ++i)
+            score += champsim::shared_load(doa_weights[cache][i][doa_index(i, ip, type)]);
+        return score;
+    }
+#endif
+
+    int perceptron_output(const std::array<int, FEATURE_COUNT>& weights, const std::array<int, FEATURE_COUNT>& features) {
+        int output = 0;
+        for (int i = 0; i < FEATURE_COUNT; ++i)
+            output += champsim::shared_load(weights[i]) * features[i];
+        return output;
+    }
+
+    // Training events, applied by the cache's training pipeline (see training_pipeline.h, PCN_TRAINING): the outcome of a
+    // fill for the dead-on-arrival predictor, or the perceptron update of one line with the features it was accessed with
+    struct training_event {
+        bool perceptron = false;
+        bool hit = false;
+        int adjustment = 0;
+        uint32_t type = 0;
+        uint64_t ip = 0;
+        std::size_t line = 0;
+        std::array<int, FEATURE_COUNT> features{};
+    };
+
+    training_event doa_event(uint64_t ip, uint32_t type, int adjustment) {
+        training_event event;
+        event.adjustment = adjustment;
+        event.type = type;
+        event.ip = ip;
+        return event;
+    }
+
+    training_event perceptron_event(std::size_t line, const std::array<int, FEATURE_COUNT>& features, bool hit) {
+        training_event event;
+        event.perceptron = true;
+        event.hit = hit;
+        event.line = line;
+        event.features = features;
+        return event;
+    }
+
+    // The tables a trainer writes, taken when the cache is initialized so that the training side never looks up a map
+    // another cache may be inserting into
+    struct training_tables {
+        std::vector<std::array<int, FEATURE_COUNT>>& weights;
+        std::vector<std::vector<int>>& doa;
+        theta_state& state;
+    };
+
+    void doa_train(std::vector<std::vector<int>>& doa, uint64_t ip, uint32_t type, int adjustment) {
+        for (int i = 0; i < DOA_FEATURE_COUNT; ++i) {
+            auto& weight = doa[i][doa_index(i, ip, type)];
+            champsim::shared_store(weight, std::clamp(weight + adjustment, WEIGHT_MIN, WEIGHT_MAX));
+        }
+    }
+
+    void train(const training_tables& tables, const training_event& event) {
+        if (!event.perceptron) {
+            doa_train(tables.doa, event.ip, event.type, event.adjustment);
+            return;
+        }
+
+        auto& weights = tables.weights[event.line];
+        auto& state = tables.state;
+        const auto& features = event.features;
+
+        // A hit means the line should have scored as live, a fill over it means it should have scored as dead
+        int output = perceptron_output(weights, features);
+        bool mispredicted = (output > 0) != event.hit;
+        bool low_confidence = std::abs(output) <= state.theta;
+
+        if (mispredicted || low_confidence) {
+            // Adjust weights based on hit or miss; the step is normalized to the feature's sign so that large feature
+            // magnitudes cannot saturate a weight in one update
+            int adjustment = event.hit ? LEARNING_RATE : -LEARNING_RATE;
+            for (size_t i = 0; i < weights.size(); ++i) {
+                int direction = (features[i] > 0) - (features[i] < 0);
+                champsim::shared_store(weights[i], std::clamp(weights[i] + adjustment * direction, WEIGHT_MIN, WEIGHT_MAX));
+            }
+
+            // Adapt theta: raise it when mispredictions dominate, lower it when most updates are merely low confidence
+            ++state.updates;
+            if (mispredicted) {
+                ++state.mispredictions;
+                if (++state.counter >= THETA_COUNTER_MAX) {
+                    state.theta = std::min(state.theta + 1, THETA_MAX);
+                    state.counter = 0;
+                }
+            } else {
+                ++state.low_confidence;
+                if (--state.counter <= -THETA_COUNTER_MAX) {
+                    state.theta = std::max(state.theta - 1, THETA_MIN);
+                    state.counter = 0;
+                }
+            }
+        }
+    }
+
+    // Declared after the tables it trains, so that its helper thread stops before they are destroyed
+    std::map<CACHE*, champsim::training_pipeline<training_event>> trainers;
+
+    // Applies a batch of hits and fills; defined below and registered for each cache by initialize_replacement()
+    void update_batch(CACHE* cache, const champsim::replacement_access* first, const champsim::replacement_access* last);
 }
 
 // Initialize perceptron weights
 void CACHE::initialize_replacement() {
-    perceptron_weights[this] = std::vector<std::vector<int>>(NUM_SET * NUM_WAY, std::vector<int>(FEATURE_COUNT, 0));
+    perceptron_weights[this] = std::vector<std::array<int, FEATURE_COUNT>>(NUM_SET * NUM_WAY);
+    last_used_cycles[this] = std::vector<uint64_t>(NUM_SET * NUM_WAY);
+    doa_weights[this] = std::vector<std::vector<int>>(DOA_FEATURE_COUNT, std::vector<int>(DOA_TABLE_SIZE, 0));
+    doa_lines[this] = std::vector<doa_line>(NUM_SET * NUM_WAY);
+    cat_partition.try_emplace(this, NAME, NUM_WAY);
+    owners.emplace(this, champsim::owner_tracker{NUM_SET, NUM_WAY});
+    presence.try_emplace(this, NAME, NUM_SET, NUM_WAY);
+    writebacks.emplace(this, champsim::writeback_policy{NUM_SET, NUM_WAY});
+    breakdown.emplace(this, champsim::access_breakdown{NAME, NUM_SET, NUM_WAY});
+    reuse.emplace(this, champsim::reuse_profiler{NUM_SET});
+    sampling.emplace(this, champsim::set_sampling{NUM_SET, NUM_WAY});
+#ifdef LLC_BYPASS
+    training_sets.emplace(this, champsim::sampler_sets{NUM_SET, DOA_TRAINING_SETS});
+    sampling.at(this).include(training_sets.at(this));
+#endif
+    top_pcs.emplace(this, champsim::pc_profile<>{NUM_SET, NUM_WAY});
+#ifdef DEAD_BLOCK_SCORING
+    scoring.emplace(this, champsim::dead_block_score{NUM_SET, NUM_WAY});
+#endif
+
+    // Warm start from an offline-trained weight file, if one was given
+    if (auto path = weight_file_path(WEIGHTS_IN_ENV, NAME); !path.empty()) {
+        if (load_weights(this, path))
+            std::cout << NAME << " PCN: loaded weights from " << path << std::endl;
+        else
+            std::cout << NAME << " PCN: could not load weights from " << path << ", starting cold" << std::endl;
+    }
+
+    const char* frozen_flag = std::getenv(FROZEN_ENV);
+    frozen[this] = frozen_flag != nullptr && (std::strcmp(frozen_flag, "1") == 0 || std::strcmp(frozen_flag, "true") == 0);
+
+    // Started after the warm start, which writes the tables directly
+    trainers.try_emplace(this, "PCN", [tables = training_tables{perceptron_weights[this], doa_weights[this], training[this]}](const training_event& event) {
+        train(tables, event);
+    });
+
+    // For callers that batch their updates (see replacement_batch.h)
+    champsim::replacement_batches()[NAME] = [this](const champsim::replacement_access* first, const champsim::replacement_access* last) {
+        update_batch(this, first, last);
+    };
 }
 
 // Find victim based on perceptron scores
 uint32_t CACHE::find_victim(uint32_t triggering_cpu, uint64_t instr_id, uint32_t set, const BLOCK* current_set, uint64_t ip, uint64_t full_addr, uint32_t type) {
+    if (!sampling.at(this).modeled(set))
+        return sampling.at(this).skipped_victim(set);
+
+#ifdef LLC_BYPASS
+    // Bypass fills predicted dead on arrival with high confidence (writebacks and the training sets must always allocate)
+    if (access_type{type} != access_type::WRITE && !training_sets.at(this).contains(set) && doa_score(this, ip, type) <= -BYPASS_THRESHOLD) {
+        bypass_stats[this].record_bypass(full_addr, ip, type);
+        return NUM_WAY;
+    }
+#endif
+
     auto begin = std::next(std::begin(perceptron_weights[this]), set * NUM_WAY);
     auto end = std::next(begin, NUM_WAY);
 
     // Calculate perceptron scores for each way
+    auto last_used = std::next(std::begin(last_used_cycles[this]), set * NUM_WAY);
     std::vector<int> scores;
-    for (auto it = begin; it != end; ++it) {
+    scores.reserve(NUM_WAY);
+    for (auto it = begin; it != end; ++it, ++last_used) {
         const auto& weights = *it;
-        // Feature vector: {access_type, recency, frequency}
-        std::vector<int> features = {
-            access_type_encoding.at(static_cast<access_type>(type)),
-            static_cast<int>(current_cycle - ::last_used_cycles[this][set * NUM_WAY + std::distance(begin, it)]),
-            1 // Placeholder for frequency if applicable
-        };
-        // Compute dot product
-        int score = std::inner_product(weights.begin(), weights.end(), features.begin(), 0);
-        scores.push_back(score);
+        auto features = make_features(type, current_cycle - *last_used);
+        scores.push_back(perceptron_output(weights, features));
     }
 
-    // Find the cache line with the lowest perceptron score
-    auto victim_it = std::min_element(scores.begin(), scores.end());
+    // Find the cache line with the lowest perceptron score among the ways this core may fill
+    auto candidates = presence.at(this).filter(set, cat_partition.at(this).victim_mask(triggering_cpu));
+    candidates = writebacks.at(this).filter(set, candidates);
+    auto victim_it = champsim::masked_min_element(scores.begin(), scores.end(), candidates);
     return static_cast<uint32_t>(std::distance(scores.begin(), victim_it));
 }
 
+namespace {
+// As update_replacement_state for each access in turn, with the cache's tables looked up once per batch
+void update_batch(CACHE* cache, const champsim::replacement_access* first, const champsim::replacement_access* last) {
+    auto& weights = perceptron_weights[cache];
+    auto& recency = last_used_cycles[cache];
+    auto& lines = doa_lines[cache];
+    auto& bypass = bypass_stats[cache];
+    auto& trainer = trainers.at(cache);
+    bool is_frozen = frozen[cache];
+    auto& cache_owners = owners.at(cache);
+    auto& cache_presence = presence.at(cache);
+    auto& cache_writebacks = writebacks.at(cache);
+    auto& cache_breakdown = breakdown.at(cache);
+    auto& cache_reuse = reuse.at(cache);
+    auto& cache_sampling = sampling.at(cache);
+    auto& cache_top_pcs = top_pcs.at(cache);
+#ifdef DEAD_BLOCK_SCORING
+    auto& cache_scoring = scoring.at(cache);
+#endif
+    auto current_cycle = cache->current_cycle;
+
+    // The set's weights, recency and dead-on-arrival state
+    auto prefetch_set = [&](uint32_t set) {
+        auto set_first = std::size_t{set} * cache->NUM_WAY;
+        champsim::prefetch_range(weights.data() + set_first, cache->NUM_WAY);
+        champsim::prefetch_range(recency.data() + set_first, cache->NUM_WAY);
+        if constexpr (DOA_PREDICTOR)
+            champsim::prefetch_range(lines.data() + set_first, cache->NUM_WAY);
+    };
+
+    champsim::for_each_set_run(first, last, prefetch_set, [&](const champsim::set_run& run) {
+        if (!cache_sampling.modeled(run.set()))
+            return;
+
+        auto set_first = std::size_t{run.set()} * cache->NUM_WAY;
+
+        for (const auto& [triggering_cpu, set, way, full_addr, ip, victim_addr, type, hit] : run) {
+            cache_sampling.record(set, type, hit);
+            trainer.access();
+            if (!hit)
+                cache_owners.miss(triggering_cpu, set, way, full_addr, victim_addr);
+            cache_presence.update(set, way, full_addr, type, hit);
+            cache_writebacks.update(set, way, type, hit);
+            cache_breakdown.update(triggering_cpu, set, way, type, hit);
+            cache_reuse.access(triggering_cpu, set, full_addr, type);
+            cache_top_pcs.update(set, way, ip, type, hit);
+#ifdef DEAD_BLOCK_SCORING
+            cache_scoring.update(set, way, type, hit);
+#endif
+
+            // The fill was bypassed, there is no line to train
+            if (way == cache->NUM_WAY)
+                continue;
+
+            std::optional<champsim::bypass_monitor<>::bypassed_fill> bypassed;
+            if (!hit && access_type{type} != access_type::WRITE) {
+                bypass.record_fill();
+                bypassed = bypass.check_miss(full_addr);
+            }
+
+#ifdef DEAD_BLOCK_SCORING
+            // The dead-on-arrival score at fill is the prediction; a score at the bypass threshold is full confidence
+            if (!hit && access_type{type} != access_type::WRITE) {
+                int score = doa_score(cache, ip, type);
+                auto confidence = static_cast<unsigned>(std::abs(score) * static_cast<int>(champsim::dead_block_score::MAX_CONFIDENCE) / BYPASS_THRESHOLD);
+                cache_scoring.predict(triggering_cpu, set, way, ip, score < 0, confidence);
+            }
+#endif
+
+            // A configured writeback placement replaces the recency update and, for an unfrozen predictor, the perceptron update
+            auto& last_used = recency[set_first + way];
+            auto to_distant = [&] { last_used = 0; };
+            auto to_near = [&] { last_used = current_cycle; };
+
+            // Inference only: the tables stay as loaded
+            if (is_frozen) {
+                if (!cache_writebacks.apply(type, hit, to_distant, to_near))
+                    last_used = current_cycle;
+                continue;
+            }
+
+            // Train the dead-on-arrival predictor with the outcome of the line's previous fill
+            if constexpr (DOA_PREDICTOR) {
+                auto& line = lines[set_first + way];
+                if (hit) {
+                    if (!line.reused)
+                        trainer.submit(doa_event(line.ip, line.type, 1));
+                    line.reused = true;
+                } else {
+                    if (line.valid && !line.reused)
+                        trainer.submit(doa_event(line.ip, line.type, -1));
+
+                    // A miss to a block we chose not to allocate means the dead prediction was wrong
+                    if (bypassed.has_value())
+                        trainer.submit(doa_event(bypassed->ip, bypassed->type, 1));
+
+                    if (access_type{type} != access_type::WRITE)
+                        line = {true, false, ip, type};
+                    else
+                        line = {};
+                }
+            }
+
+            if (cache_writebacks.apply(type, hit, to_distant, to_near))
+                continue;
+
+            trainer.submit(perceptron_event(set_first + way, make_features(type, current_cycle - last_used), hit));
+            last_used = current_cycle;
+        }
+    });
+}
+}
+
 // Update perceptron weights
 void CACHE::update_replacement_state(uint32_t triggering_cpu, uint32_t set, uint32_t way, uint64_t full_addr, uint64_t ip, uint64_t victim_addr, uint32_t type,
                                      uint8_t hit) {
-    auto& weights = perceptron_weights[this][set * NUM_WAY + way];
-    // Feature vector: {access_type, recency, frequency}
-    std::vector<int> features = {
-        access_type_encoding.at(static_cast<access_type>(type)),
-        static_cast<int>(current_cycle - ::last_used_cycles[this][set * NUM_WAY + way]),
-        1 // Placeholder for frequency if applicable
-    };
+    champsim::replacement_access access{triggering_cpu, set, way, full_addr, ip, victim_addr, type, hit};
+    update_batch(this, &access, &access + 1);
+}
+
+void CACHE::replacement_final_stats() {
+    bypass_stats[this].print(NAME);
+    cat_partition.at(this).print();
+    owners.at(this).print(NAME);
+    presence.at(this).print();
+    writebacks.at(this).print(NAME);
+    breakdown.at(this).print();
+    reuse.at(this).print(NAME);
+    sampling.at(this).print(NAME);
+    top_pcs.at(this).print(NAME);
+#ifdef DEAD_BLOCK_SCORING
+    scoring.at(this).print(NAME);
+#endif
 
-    // Adjust weights based on hit or miss
-    int adjustment = hit ? 1 : -1;
-    for (size_t i = 0; i < weights.size(); ++i) {
-        weights[i] += adjustment * features[i];
-        // Clip weights to a maximum/minimum threshold
-        weights[i] = std::max(-THRESHOLD, std::min(weights[i], THRESHOLD));
+    trainers.at(this).drain();
+    const auto& state = training[this];
+    std::size_t saturated = 0, total = 0;
+    for (const auto& weights : perceptron_weights[this]) {
+        saturated += static_cast<std::size_t>(std::count_if(weights.begin(), weights.end(), [](int w) { return w == WEIGHT_MIN || w == WEIGHT_MAX; }));
+        total += weights.size();
     }
+    std::cout << NAME << " PCN THETA: " << state.theta << " UPDATES: " << state.updates << " MISPREDICTIONS: " << state.mispredictions;
+    std::cout << " LOW CONFIDENCE: " << state.low_confidence;
+    std::cout << " SATURATED WEIGHTS: " << (total > 0 ? static_cast<double>(saturated) / static_cast<double>(total) : 0.0) << std::endl;
+    trainers.at(this).print(NAME);
+
+    if (auto path = weight_file_path(WEIGHTS_OUT_ENV, NAME); !path.empty())
+        save_weights(this, path);
 }
-//que onda perro
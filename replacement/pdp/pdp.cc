@@ -0,0 +1,260 @@
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "access_breakdown.h"
+#include "bypass_monitor.h"
+#include "cache.h"
+#include "owner_tracker.h"
+#include "packed_counters.h"
+#include "presence_hints.h"
+#include "replacement_batch.h"
+#include "reuse_profiler.h"
+#include "sampler_sets.h"
+#include "set_sampling.h"
+#include "way_partition.h"
+#include "writeback_policy.h"
+
+/*
+ * Protecting distance based replacement (Duong et al., MICRO 2012)
+ *
+ * A sampler on a few sets measures reuse distances, in accesses to the set, into a histogram. Every RECOMPUTE_INTERVAL
+ * accesses the protecting distance (PD) is set to the distance that maximizes the modelled hit rate. A line is protected
+ * for PD accesses to its set after each insertion or hit: its remaining protecting distance (RPD) is a packed counter and
+ * the whole set's RPDs are decremented, a word at a time, on every access to the set.
+ *
+ * The victim is an unprotected line. If every line is still protected the fill bypasses (with LLC_BYPASS), or else the
+ * line with the largest RPD is replaced.
+ */
+namespace
+{
+constexpr unsigned RPD_BITS = 8;
+constexpr unsigned MAX_PD = champsim::packed_counters<RPD_BITS>::maximum;
+constexpr std::size_t SAMPLER_SET = 32 * NUM_CPUS;
+constexpr std::size_t SAMPLER_ENTRIES = 64;       // per sampled set
+constexpr uint64_t RECOMPUTE_INTERVAL = 1 << 15; // accesses between PD recomputations
+constexpr unsigned HISTOGRAM_DECAY_SHIFT = 1;    // the histogram is halved after each recomputation
+
+struct sampler_entry {
+  bool valid = false;
+  uint64_t block = 0;
+  uint64_t last_access = 0;
+};
+
+struct pdp_state {
+  std::vector<uint64_t> rd_histogram = std::vector<uint64_t>(MAX_PD + 1);
+  uint64_t sampled_accesses = 0;
+  uint64_t accesses = 0;
+  unsigned protecting_distance = 0;
+  uint64_t protected_victim = 0;
+};
+
+std::map<CACHE*, champsim::sampler_sets> rand_sets;
+std::map<CACHE*, std::vector<uint64_t>> sampler_timer;
+std::map<CACHE*, std::vector<sampler_entry>> sampler;
+
+std::map<CACHE*, pdp_state> state;
+std::map<CACHE*, champsim::packed_counters<RPD_BITS>> rpd;
+std::map<CACHE*, champsim::bypass_monitor<>> bypass_stats;
+std::map<CACHE*, champsim::way_partition> cat_partition;
+std::map<CACHE*, champsim::owner_tracker> owners;
+std::map<CACHE*, champsim::presence_hints> presence;
+std::map<CACHE*, champsim::writeback_policy> writebacks;
+std::map<CACHE*, champsim::access_breakdown> breakdown;
+std::map<CACHE*, champsim::reuse_profiler> reuse;
+std::map<CACHE*, champsim::set_sampling> sampling;
+
+void sampler_access(CACHE* cache, std::size_t sample, uint64_t full_addr)
+{
+  auto& s = ::state[cache];
+  auto now = ::sampler_timer[cache][sample]++;
+  auto block = full_addr >> LOG2_BLOCK_SIZE;
+
+  auto begin = std::next(std::begin(::sampler[cache]), sample * SAMPLER_ENTRIES);
+  auto end = std::next(begin, SAMPLER_ENTRIES);
+  auto entry = std::find_if(begin, end, [block](const auto& x) { return x.valid && x.block == block; });
+
+  ++s.sampled_accesses;
+  if (entry != end) {
+    if (auto distance = now - entry->last_access; distance <= MAX_PD)
+      ++s.rd_histogram[distance];
+  } else {
+    entry = std::min_element(begin, end, [](const auto& x, const auto& y) { return std::pair{x.valid, x.last_access} < std::pair{y.valid, y.last_access}; });
+  }
+
+  *entry = {true, block, now};
+}
+
+// Choose the protecting distance that maximizes the modelled hit rate E(d)
+void recompute(pdp_state& s, unsigned associativity)
+{
+  if (s.sampled_accesses == 0)
+    return;
+
+  // E(d) = hits(d) / (sum over reused lines of their lifetime + lifetime of every other line), where reuses at distances up
+  // to d hit after i accesses and every other line occupies d + W accesses (protected, then evicted)
+  auto total = static_cast<double>(s.sampled_accesses);
+  double hits = 0, hit_lifetime = 0, best = 0;
+  unsigned best_distance = s.protecting_distance;
+  for (unsigned d = 1; d <= MAX_PD; ++d) {
+    hits += static_cast<double>(s.rd_histogram[d]);
+    hit_lifetime += static_cast<double>(s.rd_histogram[d]) * d;
+    auto occupancy = hit_lifetime + (total - hits) * (d + associativity);
+    if (auto e = hits / occupancy; e > best) {
+      best = e;
+      best_distance = d;
+    }
+  }
+
+  s.protecting_distance = best_distance;
+  for (auto& n : s.rd_histogram)
+    n >>= HISTOGRAM_DECAY_SHIFT;
+  s.sampled_accesses >>= HISTOGRAM_DECAY_SHIFT;
+}
+
+// applies a batch of hits and fills, defined below and registered for each cache by initialize_replacement()
+void update_batch(CACHE* cache, const champsim::replacement_access* first, const champsim::replacement_access* last);
+} // namespace
+
+void CACHE::initialize_replacement()
+{
+  // randomly selected sampler sets
+  ::rand_sets.emplace(this, champsim::sampler_sets{NUM_SET, ::SAMPLER_SET});
+
+  ::sampler_timer[this] = std::vector<uint64_t>(::rand_sets.at(this).size());
+  ::sampler[this] = std::vector<sampler_entry>(::rand_sets.at(this).size() * ::SAMPLER_ENTRIES);
+
+  // start out protecting for one associativity's worth of accesses, like LRU
+  ::state[this].protecting_distance = std::min<unsigned>(NUM_WAY, ::MAX_PD);
+  ::rpd.emplace(this, champsim::packed_counters<::RPD_BITS>{NUM_SET, NUM_WAY});
+  ::cat_partition.try_emplace(this, NAME, NUM_WAY);
+  ::owners.emplace(this, champsim::owner_tracker{NUM_SET, NUM_WAY});
+  ::presence.try_emplace(this, NAME, NUM_SET, NUM_WAY);
+  ::writebacks.emplace(this, champsim::writeback_policy{NUM_SET, NUM_WAY});
+  ::breakdown.emplace(this, champsim::access_breakdown{NAME, NUM_SET, NUM_WAY});
+  ::reuse.emplace(this, champsim::reuse_profiler{NUM_SET});
+  ::sampling.emplace(this, champsim::set_sampling{NUM_SET, NUM_WAY});
+  ::sampling.at(this).include(::rand_sets.at(this));
+
+  // for callers that batch their updates (see replacement_batch.h)
+  champsim::replacement_batches()[NAME] = [this](const champsim::replacement_access* first, const champsim::replacement_access* last) {
+    ::update_batch(this, first, last);
+  };
+}
+
+// find replacement victim
+uint32_t CACHE::find_victim(uint32_t triggering_cpu, uint64_t instr_id, uint32_t set, const BLOCK* current_set, uint64_t ip, uint64_t full_addr, uint32_t type)
+{
+  if (!::sampling.at(this).modeled(set))
+    return ::sampling.at(this).skipped_victim(set);
+
+  auto& set_rpd = ::rpd.at(this);
+  auto candidates = ::presence.at(this).filter(set, ::cat_partition.at(this).victim_mask(triggering_cpu));
+  candidates = ::writebacks.at(this).filter(set, candidates);
+
+  // prefer an unprotected line
+  auto victim = set_rpd.find(set, 0, candidates);
+  if (victim == NUM_WAY) {
+#ifdef LLC_BYPASS
+    if (access_type{type} != access_type::WRITE) {
+      ::bypass_stats[this].record_bypass(full_addr, ip, type);
+      return NUM_WAY;
+    }
+#endif
+
+    ++::state[this].protected_victim;
+    victim = set_rpd.find(set, set_rpd.row_max(set, candidates), candidates);
+  }
+
+  assert(victim < NUM_WAY);
+  return static_cast<uint32_t>(victim); // cast protected by assertion
+}
+
+namespace
+{
+// called with runs of hits and fills to one set
+void update_batch(CACHE* cache, const champsim::replacement_access* first, const champsim::replacement_access* last)
+{
+  auto& s = ::state[cache];
+  auto& rand_sets = ::rand_sets.at(cache);
+  auto& bypass_stats = ::bypass_stats[cache];
+  auto& set_rpd = ::rpd.at(cache);
+  auto& owners = ::owners.at(cache);
+  auto& presence = ::presence.at(cache);
+  auto& writebacks = ::writebacks.at(cache);
+  auto& breakdown = ::breakdown.at(cache);
+  auto& reuse = ::reuse.at(cache);
+  auto& sampling = ::sampling.at(cache);
+
+  auto prefetch_set = [&](uint32_t set) { set_rpd.prefetch_row(set); };
+
+  champsim::for_each_set_run(first, last, prefetch_set, [&](const champsim::set_run& run) {
+    if (!sampling.modeled(run.set()))
+      return;
+
+    // the set's place among the sampler sets, if it has one
+    auto sample = rand_sets.index(run.set());
+
+    for (const auto& access : run) {
+      const auto& [triggering_cpu, set, way, full_addr, ip, victim_addr, type, hit] = access;
+      sampling.record(set, type, hit);
+      if (!hit)
+        owners.miss(triggering_cpu, set, way, full_addr, victim_addr);
+      presence.update(set, way, full_addr, type, hit);
+      writebacks.update(set, way, type, hit);
+      breakdown.update(triggering_cpu, set, way, type, hit);
+      reuse.access(triggering_cpu, set, full_addr, type);
+
+      // every access to the set brings each line one access closer to losing its protection
+      set_rpd.decrement_row(set);
+
+      if (access_type{type} != access_type::WRITE && sample.has_value())
+        ::sampler_access(cache, *sample, full_addr);
+
+      if (++s.accesses % ::RECOMPUTE_INTERVAL == 0)
+        ::recompute(s, cache->NUM_WAY);
+
+      // the fill was bypassed, there is no line to update
+      if (way == cache->NUM_WAY)
+        continue;
+
+      if (!hit && access_type{type} != access_type::WRITE) {
+        bypass_stats.record_fill();
+        bypass_stats.check_miss(full_addr);
+      }
+
+      if (writebacks.apply(type, hit, [&] { set_rpd.set(access.set, access.way, 0); }, [&] { set_rpd.set(access.set, access.way, s.protecting_distance); }))
+        continue;
+
+      if (!hit || access_type{type} != access_type::WRITE) // Skip this for writeback hits
+        set_rpd.set(set, way, s.protecting_distance);
+    }
+  });
+}
+} // namespace
+
+// called on every cache hit and cache fill
+void CACHE::update_replacement_state(uint32_t triggering_cpu, uint32_t set, uint32_t way, uint64_t full_addr, uint64_t ip, uint64_t victim_addr, uint32_t type,
+                                     uint8_t hit)
+{
+  champsim::replacement_access access{triggering_cpu, set, way, full_addr, ip, victim_addr, type, hit};
+  ::update_batch(this, &access, &access + 1);
+}
+
+// use this function to print out your own stats at the end of simulation
+void CACHE::replacement_final_stats()
+{
+  ::cat_partition.at(this).print();
+  ::owners.at(this).print(NAME);
+  ::presence.at(this).print();
+  ::writebacks.at(this).print(NAME);
+  ::breakdown.at(this).print();
+  ::reuse.at(this).print(NAME);
+  ::sampling.at(this).print(NAME);
+  ::bypass_stats[this].print(NAME);
+  std::cout << NAME << " PDP PROTECTING DISTANCE: " << ::state[this].protecting_distance << " PROTECTED VICTIM: " << ::state[this].protected_victim << std::endl;
+}
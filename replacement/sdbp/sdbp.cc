@@ -0,0 +1,314 @@
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "access_breakdown.h"
+#include "bypass_monitor.h"
+#include "cache.h"
+#include "metadata_prefetch.h"
+#include "msl/bits.h"
+#include "owner_tracker.h"
+#include "packed_counters.h"
+#include "presence_hints.h"
+#include "replacement_batch.h"
+#include "reuse_profiler.h"
+#include "sampler_sets.h"
+#include "set_sampling.h"
+#include "way_mask.h"
+#include "way_partition.h"
+#include "writeback_policy.h"
+
+/*
+ * Sampling dead block prediction (Khan, Tian and Jimenez, MICRO 2010)
+ *
+ * A small decoupled sampler, with fewer ways than the cache and partial tags, tracks the accesses to a few sets. When a
+ * sampler entry is hit, the PC that last touched it is trained as live; when it is evicted, that PC is trained as dead. The
+ * predictor is three skewed tables of 2-bit counters indexed by different hashes of the PC, and a block is predicted dead
+ * when the summed confidence reaches DEAD_THRESHOLD.
+ *
+ * Each line carries a dead bit refreshed on every access. Dead lines are evicted first; otherwise the default policy (LRU,
+ * or SRRIP if DEFAULT_RRIP is set) picks the victim. With LLC_BYPASS, fills predicted dead are not allocated.
+ */
+namespace
+{
+constexpr std::size_t SAMPLER_SET = 32 * NUM_CPUS;
+constexpr std::size_t SAMPLER_WAYS = 12;
+constexpr unsigned SAMPLER_TAG_BITS = 15;
+constexpr std::size_t NUM_TABLES = 3;
+constexpr std::size_t TABLE_SIZE = 4096;
+constexpr unsigned COUNTER_BITS = 2;
+constexpr unsigned DEAD_THRESHOLD = 8; // out of NUM_TABLES * 3
+constexpr bool DEFAULT_RRIP = false;
+constexpr unsigned RRPV_BITS = 2;
+constexpr unsigned maxRRPV = champsim::packed_counters<RRPV_BITS>::maximum;
+
+// sampler structure
+class SAMPLER_class
+{
+public:
+  bool valid = false;
+  uint16_t tag = 0;
+  uint64_t ip = 0;
+  uint64_t last_used = 0;
+};
+
+// sampler
+std::map<CACHE*, champsim::sampler_sets> rand_sets;
+std::map<CACHE*, std::vector<SAMPLER_class>> sampler;
+
+// skewed prediction tables, one row per table
+std::map<CACHE*, champsim::packed_counters<COUNTER_BITS>> predictor;
+
+std::map<CACHE*, champsim::packed_counters<1>> dead;
+std::map<CACHE*, std::vector<uint64_t>> last_used_cycles;
+std::map<CACHE*, champsim::packed_counters<RRPV_BITS>> rrpv;
+std::map<CACHE*, champsim::bypass_monitor<>> bypass_stats;
+std::map<CACHE*, champsim::way_partition> cat_partition;
+std::map<CACHE*, champsim::owner_tracker> owners;
+std::map<CACHE*, champsim::presence_hints> presence;
+std::map<CACHE*, champsim::writeback_policy> writebacks;
+std::map<CACHE*, champsim::access_breakdown> breakdown;
+std::map<CACHE*, champsim::reuse_profiler> reuse;
+std::map<CACHE*, champsim::set_sampling> sampling;
+
+struct sdbp_stats {
+  uint64_t dead_victim = 0;
+  uint64_t default_victim = 0;
+};
+std::map<CACHE*, sdbp_stats> stats;
+
+std::size_t table_index(std::size_t table, uint64_t ip)
+{
+  constexpr std::array<uint64_t, NUM_TABLES> multipliers = {0x9E3779B97F4A7C15ull, 0xC2B2AE3D27D4EB4Full, 0x165667B19E3779F9ull};
+  auto hash = (ip ^ (ip >> (11 + 7 * table))) * multipliers[table];
+  return static_cast<std::size_t>(hash >> 40) % TABLE_SIZE;
+}
+
+unsigned confidence(CACHE* cache, uint64_t ip)
+{
+  unsigned sum = 0;
+  for (std::size_t t = 0; t < NUM_TABLES; ++t)
+    sum += ::predictor.at(cache).get(t, table_index(t, ip));
+  return sum;
+}
+
+bool predict_dead(CACHE* cache, uint64_t ip) { return confidence(cache, ip) >= DEAD_THRESHOLD; }
+
+void train(CACHE* cache, uint64_t ip, bool is_dead)
+{
+  for (std::size_t t = 0; t < NUM_TABLES; ++t) {
+    if (is_dead)
+      ::predictor.at(cache).increment(t, table_index(t, ip));
+    else
+      ::predictor.at(cache).decrement(t, table_index(t, ip));
+  }
+}
+
+void sampler_access(CACHE* cache, std::size_t s_idx, uint64_t full_addr, uint64_t ip)
+{
+  auto s_set_begin = std::next(std::begin(::sampler[cache]), s_idx * SAMPLER_WAYS);
+  auto s_set_end = std::next(s_set_begin, SAMPLER_WAYS);
+  auto tag = static_cast<uint16_t>((full_addr >> (LOG2_BLOCK_SIZE + champsim::lg2(cache->NUM_SET))) & champsim::bitmask(SAMPLER_TAG_BITS));
+
+  // check hit
+  auto match = std::find_if(s_set_begin, s_set_end, [tag](const auto& x) { return x.valid && x.tag == tag; });
+  if (match != s_set_end) {
+    // the previous touch was not the last one
+    ::train(cache, match->ip, false);
+  } else {
+    match = std::min_element(s_set_begin, s_set_end, [](const auto& x, const auto& y) { return std::pair{x.valid, x.last_used} < std::pair{y.valid, y.last_used}; });
+
+    // the evicted block's last touch was its last
+    if (match->valid)
+      ::train(cache, match->ip, true);
+
+    match->valid = true;
+    match->tag = tag;
+  }
+
+  // update LRU state
+  match->ip = ip;
+  match->last_used = cache->current_cycle;
+}
+
+// applies a batch of hits and fills, defined below and registered for each cache by initialize_replacement()
+void update_batch(CACHE* cache, const champsim::replacement_access* first, const champsim::replacement_access* last);
+} // namespace
+
+// initialize replacement state
+void CACHE::initialize_replacement()
+{
+  // randomly selected sampler sets
+  ::rand_sets.emplace(this, champsim::sampler_sets{NUM_SET, ::SAMPLER_SET});
+
+  ::sampler[this] = std::vector<SAMPLER_class>(::rand_sets.at(this).size() * ::SAMPLER_WAYS);
+  ::predictor.emplace(this, champsim::packed_counters<::COUNTER_BITS>{::NUM_TABLES, ::TABLE_SIZE});
+
+  ::dead.emplace(this, champsim::packed_counters<1>{NUM_SET, NUM_WAY});
+  if constexpr (::DEFAULT_RRIP)
+    ::rrpv.emplace(this, champsim::packed_counters<::RRPV_BITS>{NUM_SET, NUM_WAY, ::maxRRPV});
+  else
+    ::last_used_cycles[this] = std::vector<uint64_t>(NUM_SET * NUM_WAY);
+  ::cat_partition.try_emplace(this, NAME, NUM_WAY);
+  ::owners.emplace(this, champsim::owner_tracker{NUM_SET, NUM_WAY});
+  ::presence.try_emplace(this, NAME, NUM_SET, NUM_WAY);
+  ::writebacks.emplace(this, champsim::writeback_policy{NUM_SET, NUM_WAY});
+  ::breakdown.emplace(this, champsim::access_breakdown{NAME, NUM_SET, NUM_WAY});
+  ::reuse.emplace(this, champsim::reuse_profiler{NUM_SET});
+  ::sampling.emplace(this, champsim::set_sampling{NUM_SET, NUM_WAY});
+  ::sampling.at(this).include(::rand_sets.at(this));
+
+  // for callers that batch their updates (see replacement_batch.h)
+  champsim::replacement_batches()[NAME] = [this](const champsim::replacement_access* first, const champsim::replacement_access* last) {
+    ::update_batch(this, first, last);
+  };
+}
+
+// find replacement victim
+uint32_t CACHE::find_victim(uint32_t triggering_cpu, uint64_t instr_id, uint32_t set, const BLOCK* current_set, uint64_t ip, uint64_t full_addr, uint32_t type)
+{
+  if (!::sampling.at(this).modeled(set))
+    return ::sampling.at(this).skipped_victim(set);
+
+#ifdef LLC_BYPASS
+  if (access_type{type} != access_type::WRITE && ::predict_dead(this, ip)) {
+    ::bypass_stats[this].record_bypass(full_addr, ip, type);
+    return NUM_WAY;
+  }
+#endif
+
+  auto candidates = ::presence.at(this).filter(set, ::cat_partition.at(this).victim_mask(triggering_cpu));
+  candidates = ::writebacks.at(this).filter(set, candidates);
+
+  // prefer a block predicted dead
+  auto victim = ::dead.at(this).find(set, 1, candidates);
+  if (victim < NUM_WAY) {
+    ++::stats[this].dead_victim;
+    return static_cast<uint32_t>(victim);
+  }
+
+  ++::stats[this].default_victim;
+  if constexpr (::DEFAULT_RRIP) {
+    victim = champsim::rrip_find_victim(::rrpv.at(this), set, candidates);
+  } else {
+    auto begin = std::next(std::begin(::last_used_cycles[this]), set * NUM_WAY);
+    victim = static_cast<std::size_t>(std::distance(begin, champsim::masked_min_element(begin, std::next(begin, NUM_WAY), candidates)));
+  }
+
+  assert(victim < NUM_WAY);
+  return static_cast<uint32_t>(victim); // cast protected by assertion
+}
+
+namespace
+{
+// called with runs of hits and fills to one set
+void update_batch(CACHE* cache, const champsim::replacement_access* first, const champsim::replacement_access* last)
+{
+  auto& rand_sets = ::rand_sets.at(cache);
+  auto& last_used_cycles = ::last_used_cycles[cache]; // empty with DEFAULT_RRIP
+  auto& bypass_stats = ::bypass_stats[cache];
+  auto& dead = ::dead.at(cache);
+  auto& owners = ::owners.at(cache);
+  auto& presence = ::presence.at(cache);
+  auto& writebacks = ::writebacks.at(cache);
+  auto& breakdown = ::breakdown.at(cache);
+  auto& reuse = ::reuse.at(cache);
+  auto& sampling = ::sampling.at(cache);
+
+  auto* rrpv = ::DEFAULT_RRIP ? &::rrpv.at(cache) : nullptr;
+  auto prefetch_set = [&](uint32_t set) {
+    dead.prefetch_row(set);
+    if constexpr (::DEFAULT_RRIP)
+      rrpv->prefetch_row(set);
+    else
+      champsim::prefetch_range(last_used_cycles.data() + std::size_t{set} * cache->NUM_WAY, cache->NUM_WAY);
+  };
+
+  champsim::for_each_set_run(first, last, prefetch_set, [&](const champsim::set_run& run) {
+    if (!sampling.modeled(run.set()))
+      return;
+
+    // the set's place among the sampler sets, if it has one
+    auto sample = rand_sets.index(run.set());
+
+    for (const auto& access : run) {
+      const auto& [triggering_cpu, set, way, full_addr, ip, victim_addr, type, hit] = access;
+      sampling.record(set, type, hit);
+      if (!hit)
+        owners.miss(triggering_cpu, set, way, full_addr, victim_addr);
+      presence.update(set, way, full_addr, type, hit);
+      writebacks.update(set, way, type, hit);
+      breakdown.update(triggering_cpu, set, way, type, hit);
+      reuse.access(triggering_cpu, set, full_addr, type);
+
+      // writebacks do not train the sampler, and a written-back line carries no prediction
+      if (access_type{type} != access_type::WRITE && sample.has_value())
+        ::sampler_access(cache, *sample, full_addr, ip);
+
+      // the fill was bypassed, there is no line to update
+      if (way == cache->NUM_WAY)
+        continue;
+
+      if (!hit && access_type{type} != access_type::WRITE) {
+        bypass_stats.record_fill();
+        bypass_stats.check_miss(full_addr);
+      }
+
+      auto to_distant = [&] {
+        dead.set(access.set, access.way, 1);
+        if constexpr (::DEFAULT_RRIP)
+          rrpv->set(access.set, access.way, ::maxRRPV);
+        else
+          last_used_cycles[access.set * cache->NUM_WAY + access.way] = 0;
+      };
+      auto to_near = [&] {
+        dead.set(access.set, access.way, 0);
+        if constexpr (::DEFAULT_RRIP)
+          rrpv->set(access.set, access.way, 0);
+        else
+          last_used_cycles[access.set * cache->NUM_WAY + access.way] = cache->current_cycle;
+      };
+      if (writebacks.apply(type, hit, to_distant, to_near))
+        continue;
+
+      dead.set(set, way, access_type{type} != access_type::WRITE && ::predict_dead(cache, ip));
+
+      if constexpr (::DEFAULT_RRIP) {
+        if (hit)
+          rrpv->set(set, way, 0);
+        else
+          rrpv->set(set, way, ::maxRRPV - 1);
+      } else if (!hit || access_type{type} != access_type::WRITE) { // Skip this for writeback hits
+        last_used_cycles[set * cache->NUM_WAY + way] = cache->current_cycle;
+      }
+    }
+  });
+}
+} // namespace
+
+// called on every cache hit and cache fill
+void CACHE::update_replacement_state(uint32_t triggering_cpu, uint32_t set, uint32_t way, uint64_t full_addr, uint64_t ip, uint64_t victim_addr, uint32_t type,
+                                     uint8_t hit)
+{
+  champsim::replacement_access access{triggering_cpu, set, way, full_addr, ip, victim_addr, type, hit};
+  ::update_batch(this, &access, &access + 1);
+}
+
+// use this function to print out your own stats at the end of simulation
+void CACHE::replacement_final_stats()
+{
+  ::cat_partition.at(this).print();
+  ::owners.at(this).print(NAME);
+  ::presence.at(this).print();
+  ::writebacks.at(this).print(NAME);
+  ::breakdown.at(this).print();
+  ::reuse.at(this).print(NAME);
+  ::sampling.at(this).print(NAME);
+  ::bypass_stats[this].print(NAME);
+  std::cout << NAME << " SDBP DEAD VICTIM: " << ::stats[this].dead_victim << " DEFAULT VICTIM: " << ::stats[this].default_victim << std::endl;
+}
@@ -5,8 +5,30 @@
 #include <utility>
 #include <vector>
 
+#include "access_breakdown.h"
+#include "bypass_monitor.h"
 #include "cache.h"
+#include "metadata_prefetch.h"
 #include "msl/bits.h"
+#include "owner_tracker.h"
+#include "pc_profile.h"
+#include "presence_hints.h"
+#include "replacement_batch.h"
+#include "reuse_profiler.h"
+#include "sampler_sets.h"
+#include "set_sampling.h"
+#include "training_pipeline.h"
+#include "way_mask.h"
+#include "way_partition.h"
+#include "writeback_policy.h"
+
+#ifdef UCP_PARTITION
+#include "ucp.h"
+#endif
+
+#ifdef DEAD_BLOCK_SCORING
+#include "dead_block_score.h"
+#endif
 
 namespace
 {
@@ -27,113 +49,286 @@ public:
 };
 
 // sampler
-std::map<CACHE*, std::vector<std::size_t>> rand_sets;
+std::map<CACHE*, champsim::sampler_sets> rand_sets;
 std::map<CACHE*, std::vector<SAMPLER_class>> sampler;
 std::map<CACHE*, std::vector<int>> rrpv_values;
+std::map<CACHE*, champsim::bypass_monitor<>> bypass_stats;
+std::map<CACHE*, champsim::way_partition> cat_partition;
+std::map<CACHE*, champsim::owner_tracker> owners;
+std::map<CACHE*, champsim::presence_hints> presence;
+std::map<CACHE*, champsim::writeback_policy> writebacks;
+std::map<CACHE*, champsim::access_breakdown> breakdown;
+std::map<CACHE*, champsim::reuse_profiler> reuse;
+std::map<CACHE*, champsim::set_sampling> sampling;
+std::map<CACHE*, champsim::pc_profile<>> top_pcs;
+
+#ifdef UCP_PARTITION
+std::map<CACHE*, champsim::ucp> partition;
+#endif
+
+#ifdef DEAD_BLOCK_SCORING
+std::map<CACHE*, champsim::dead_block_score> scoring;
+#endif
 
 // prediction table structure
 std::map<std::pair<CACHE*, std::size_t>, std::array<unsigned, SHCT_SIZE>> SHCT;
+
+// a fill or hit to a sampler set, which trains the SHCT
+struct training_event {
+  uint32_t cpu = 0;
+  uint32_t sample = 0; // the set's place among the sampler sets
+  uint64_t full_addr = 0;
+  uint64_t ip = 0;
+  uint64_t cycle = 0;
+};
+
+// declared last so that its helper thread stops before the tables it trains are destroyed
+std::map<CACHE*, champsim::training_pipeline<training_event>> training;
+
+// the training side: only the trainer touches the sampler, and it writes the SHCT with shared_store()
+void sampler_access(std::vector<SAMPLER_class>& sampler, std::array<unsigned, SHCT_SIZE>& shct, uint32_t num_way, const training_event& event)
+{
+  auto s_set_begin = std::next(std::begin(sampler), event.sample);
+  auto s_set_end = std::next(s_set_begin, num_way);
+
+  // check hit
+  auto match = std::find_if(s_set_begin, s_set_end, [addr = event.full_addr, shamt = 8 + champsim::lg2(num_way)](auto x) {
+    return x.valid && (x.address >> shamt) == (addr >> shamt);
+  });
+  if (match != s_set_end) {
+    auto SHCT_idx = match->ip % ::SHCT_PRIME;
+    if (shct[SHCT_idx] > 0)
+      champsim::shared_store(shct[SHCT_idx], shct[SHCT_idx] - 1);
+
+    match->used = 1;
+  } else {
+    match = std::min_element(s_set_begin, s_set_end, [](auto x, auto y) { return x.last_used < y.last_used; });
+
+    if (match->used) {
+      auto SHCT_idx = match->ip % ::SHCT_PRIME;
+      if (shct[SHCT_idx] < ::SHCT_MAX)
+        champsim::shared_store(shct[SHCT_idx], shct[SHCT_idx] + 1);
+    }
+
+    match->valid = 1;
+    match->address = event.full_addr;
+    match->ip = event.ip;
+    match->used = 0;
+  }
+
+  // update LRU state
+  match->last_used = event.cycle;
+}
+
+// applies a batch of hits and fills, defined below and registered for each cache by initialize_replacement()
+void update_batch(CACHE* cache, const champsim::replacement_access* first, const champsim::replacement_access* last);
 } // namespace
 
 // initialize replacement state
 void CACHE::initialize_replacement()
 {
   // randomly selected sampler sets
-  std::size_t rand_seed = 1103515245 + 12345;
-  ;
-  for (std::size_t i = 0; i < ::SAMPLER_SET; i++) {
-    std::size_t val = (rand_seed / 65536) % NUM_SET;
-    std::vector<std::size_t>::iterator loc = std::lower_bound(std::begin(::rand_sets[this]), std::end(::rand_sets[this]), val);
-
-    while (loc != std::end(::rand_sets[this]) && *loc == val) {
-      rand_seed = rand_seed * 1103515245 + 12345;
-      val = (rand_seed / 65536) % NUM_SET;
-      loc = std::lower_bound(std::begin(::rand_sets[this]), std::end(::rand_sets[this]), val);
-    }
-
-    ::rand_sets[this].insert(loc, val);
-  }
+  ::rand_sets.emplace(this, champsim::sampler_sets{NUM_SET, ::SAMPLER_SET});
 
   sampler.emplace(this, ::SAMPLER_SET * NUM_WAY);
 
+  // the trainer holds its own references, so that it never looks up a map another cache may be inserting into
+  std::vector<std::array<unsigned, ::SHCT_SIZE>*> shct;
+  for (std::size_t cpu = 0; cpu < NUM_CPUS; ++cpu)
+    shct.push_back(&::SHCT[std::make_pair(this, cpu)]);
+  ::training.try_emplace(this, "SHIP", [&sampler = ::sampler[this], shct, num_way = NUM_WAY](const ::training_event& event) {
+    ::sampler_access(sampler, *shct[event.cpu], num_way, event);
+  });
+
   ::rrpv_values[this] = std::vector<int>(NUM_SET * NUM_WAY, ::maxRRPV);
+  ::cat_partition.try_emplace(this, NAME, NUM_WAY);
+  ::owners.emplace(this, champsim::owner_tracker{NUM_SET, NUM_WAY});
+  ::presence.try_emplace(this, NAME, NUM_SET, NUM_WAY);
+  ::writebacks.emplace(this, champsim::writeback_policy{NUM_SET, NUM_WAY});
+  ::breakdown.emplace(this, champsim::access_breakdown{NAME, NUM_SET, NUM_WAY});
+  ::reuse.emplace(this, champsim::reuse_profiler{NUM_SET});
+  ::sampling.emplace(this, champsim::set_sampling{NUM_SET, NUM_WAY});
+  ::sampling.at(this).include(::rand_sets.at(this));
+  ::top_pcs.emplace(this, champsim::pc_profile<>{NUM_SET, NUM_WAY});
+#ifdef UCP_PARTITION
+  ::partition.emplace(this, champsim::ucp{NUM_SET, NUM_WAY});
+#endif
+#ifdef DEAD_BLOCK_SCORING
+  ::scoring.emplace(this, champsim::dead_block_score{NUM_SET, NUM_WAY});
+#endif
+
+  // for callers that batch their updates (see replacement_batch.h)
+  champsim::replacement_batches()[NAME] = [this](const champsim::replacement_access* first, const champsim::replacement_access* last) {
+    ::update_batch(this, first, last);
+  };
 }
 
 // find replacement victim
 uint32_t CACHE::find_victim(uint32_t triggering_cpu, uint64_t instr_id, uint32_t set, const BLOCK* current_set, uint64_t ip, uint64_t full_addr, uint32_t type)
 {
+  if (!::sampling.at(this).modeled(set))
+    return ::sampling.at(this).skipped_victim(set);
+
+#ifdef LLC_BYPASS
+  // bypass fills whose signature is saturated at dead-on-arrival; sampler sets always allocate so the SHCT keeps training
+  if (access_type{type} != access_type::WRITE && champsim::shared_load(::SHCT[std::make_pair(this, triggering_cpu)][ip % ::SHCT_PRIME]) == ::SHCT_MAX
+      && !::rand_sets.at(this).contains(set)) {
+    ::bypass_stats[this].record_bypass(full_addr, ip, type);
+    return NUM_WAY;
+  }
+#endif
+
+  auto candidates = ::cat_partition.at(this).victim_mask(triggering_cpu);
+#ifdef UCP_PARTITION
+  if (auto ucp_candidates = candidates & ::partition.at(this).victim_mask(triggering_cpu, set, ::owners.at(this)); ucp_candidates != 0)
+    candidates = ucp_candidates;
+#endif
+  candidates = ::presence.at(this).filter(set, candidates);
+  candidates = ::writebacks.at(this).filter(set, candidates);
+
   // look for the maxRRPV line
   auto begin = std::next(std::begin(::rrpv_values[this]), set * NUM_WAY);
   auto end = std::next(begin, NUM_WAY);
-  auto victim = std::find(begin, end, ::maxRRPV);
+  auto victim = champsim::masked_find(begin, end, candidates, ::maxRRPV);
   while (victim == end) {
+    // lines outside the candidates may already be at maxRRPV
     for (auto it = begin; it != end; ++it)
-      ++(*it);
+      *it = std::min(*it + 1, ::maxRRPV);
 
-    victim = std::find(begin, end, ::maxRRPV);
+    victim = champsim::masked_find(begin, end, candidates, ::maxRRPV);
   }
 
   assert(begin <= victim);
   return static_cast<uint32_t>(std::distance(begin, victim)); // cast pretected by prior assert
 }
 
-// called on every cache hit and cache fill
-void CACHE::update_replacement_state(uint32_t triggering_cpu, uint32_t set, uint32_t way, uint64_t full_addr, uint64_t ip, uint64_t victim_addr, uint32_t type,
-                                     uint8_t hit)
+namespace
 {
-  // handle writeback access
-  if (access_type{type} == access_type::WRITE) {
-    if (!hit)
-      ::rrpv_values[this][set * NUM_WAY + way] = ::maxRRPV - 1;
+// called with runs of hits and fills to one set
+void update_batch(CACHE* cache, const champsim::replacement_access* first, const champsim::replacement_access* last)
+{
+  auto& rand_sets = ::rand_sets.at(cache);
+  auto& training = ::training.at(cache);
+  auto& rrpv_values = ::rrpv_values[cache];
+  auto& bypass_stats = ::bypass_stats[cache];
+  auto& owners = ::owners.at(cache);
+  auto& presence = ::presence.at(cache);
+  auto& writebacks = ::writebacks.at(cache);
+  auto& breakdown = ::breakdown.at(cache);
+  auto& reuse = ::reuse.at(cache);
+  auto& sampling = ::sampling.at(cache);
+  auto& top_pcs = ::top_pcs.at(cache);
+#ifdef UCP_PARTITION
+  auto& partition = ::partition.at(cache);
+#endif
+#ifdef DEAD_BLOCK_SCORING
+  auto& scoring = ::scoring.at(cache);
+#endif
 
-    return;
-  }
+  auto prefetch_set = [&](uint32_t set) { champsim::prefetch_range(rrpv_values.data() + std::size_t{set} * cache->NUM_WAY, cache->NUM_WAY); };
 
-  // update sampler
-  auto s_idx = std::find(std::begin(::rand_sets[this]), std::end(::rand_sets[this]), set);
-  if (s_idx != std::end(::rand_sets[this])) {
-    auto s_set_begin = std::next(std::begin(sampler[this]), std::distance(std::begin(::rand_sets[this]), s_idx));
-    auto s_set_end = std::next(s_set_begin, NUM_WAY);
+  champsim::for_each_set_run(first, last, prefetch_set, [&](const champsim::set_run& run) {
+    if (!sampling.modeled(run.set()))
+      return;
 
-    // check hit
-    auto match = std::find_if(s_set_begin, s_set_end,
-                              [addr = full_addr, shamt = 8 + champsim::lg2(NUM_WAY)](auto x) { return x.valid && (x.address >> shamt) == (addr >> shamt); });
-    if (match != s_set_end) {
-      auto SHCT_idx = match->ip % ::SHCT_PRIME;
-      if (::SHCT[std::make_pair(this, triggering_cpu)][SHCT_idx] > 0)
-        ::SHCT[std::make_pair(this, triggering_cpu)][SHCT_idx]--;
+    auto set_rrpv = rrpv_values.data() + std::size_t{run.set()} * cache->NUM_WAY;
 
-      match->used = 1;
-    } else {
-      match = std::min_element(s_set_begin, s_set_end, [](auto x, auto y) { return x.last_used < y.last_used; });
+    // the set's place among the sampler sets, if it has one
+    auto s_idx = rand_sets.index(run.set());
 
-      if (match->used) {
-        auto SHCT_idx = match->ip % ::SHCT_PRIME;
-        if (::SHCT[std::make_pair(this, triggering_cpu)][SHCT_idx] < ::SHCT_MAX)
-          ::SHCT[std::make_pair(this, triggering_cpu)][SHCT_idx]++;
+    for (const auto& [triggering_cpu, set, way, full_addr, ip, victim_addr, type, hit] : run) {
+      sampling.record(set, type, hit);
+      training.access();
+#ifdef UCP_PARTITION
+      if (access_type{type} != access_type::WRITE)
+        partition.access(triggering_cpu, set, full_addr);
+#endif
+      if (!hit)
+        owners.miss(triggering_cpu, set, way, full_addr, victim_addr);
+      presence.update(set, way, full_addr, type, hit);
+      writebacks.update(set, way, type, hit);
+      breakdown.update(triggering_cpu, set, way, type, hit);
+      reuse.access(triggering_cpu, set, full_addr, type);
+      top_pcs.update(set, way, ip, type, hit);
+#ifdef DEAD_BLOCK_SCORING
+      scoring.update(set, way, type, hit);
+#endif
+
+      // the fill was bypassed, there is no line to update
+      if (way == cache->NUM_WAY)
+        continue;
+
+      auto& line_rrpv = set_rrpv[way];
+      if (writebacks.apply(type, hit, [&] { line_rrpv = ::maxRRPV; }, [&] { line_rrpv = 0; }))
+        continue;
+
+      // handle writeback access
+      if (access_type{type} == access_type::WRITE) {
+        if (!hit)
+          line_rrpv = ::maxRRPV - 1;
+
+        continue;
       }
 
-      match->valid = 1;
-      match->address = full_addr;
-      match->ip = ip;
-      match->used = 0;
-    }
+      auto& shct = ::SHCT[std::make_pair(cache, triggering_cpu)];
 
-    // update LRU state
-    match->last_used = current_cycle;
-  }
+      // train on the sampler sets (they never bypass, so a bypassed fill has nothing to train)
+      if (s_idx.has_value())
+        training.submit({triggering_cpu, static_cast<uint32_t>(*s_idx), full_addr, ip, cache->current_cycle});
+
+      if (!hit) {
+        bypass_stats.record_fill();
+        bypass_stats.check_miss(full_addr);
+      }
 
-  if (hit)
-    ::rrpv_values[this][set * NUM_WAY + way] = 0;
-  else {
-    // SHIP prediction
-    auto SHCT_idx = ip % ::SHCT_PRIME;
+      if (hit)
+        line_rrpv = 0;
+      else {
+        // SHIP prediction
+        auto SHCT_idx = ip % ::SHCT_PRIME;
 
-    ::rrpv_values[this][set * NUM_WAY + way] = ::maxRRPV - 1;
-    if (::SHCT[std::make_pair(this, triggering_cpu)][SHCT_idx] == ::SHCT_MAX)
-      ::rrpv_values[this][set * NUM_WAY + way] = ::maxRRPV;
-  }
+        line_rrpv = ::maxRRPV - 1;
+        if (champsim::shared_load(shct[SHCT_idx]) == ::SHCT_MAX)
+          line_rrpv = ::maxRRPV;
+
+#ifdef DEAD_BLOCK_SCORING
+        // a saturated counter predicts dead; the further below it, the more confident the prediction of reuse
+        auto counter = champsim::shared_load(shct[SHCT_idx]);
+        scoring.predict(triggering_cpu, set, way, ip, counter == ::SHCT_MAX,
+                        counter == ::SHCT_MAX ? champsim::dead_block_score::MAX_CONFIDENCE : (::SHCT_MAX - 1 - counter) * 4 / ::SHCT_MAX);
+#endif
+      }
+    }
+  });
+}
+} // namespace
+
+// called on every cache hit and cache fill
+void CACHE::update_replacement_state(uint32_t triggering_cpu, uint32_t set, uint32_t way, uint64_t full_addr, uint64_t ip, uint64_t victim_addr, uint32_t type,
+                                     uint8_t hit)
+{
+  champsim::replacement_access access{triggering_cpu, set, way, full_addr, ip, victim_addr, type, hit};
+  ::update_batch(this, &access, &access + 1);
 }
 
 // use this function to print out your own stats at the end of simulation
-void CACHE::replacement_final_stats() {}
+void CACHE::replacement_final_stats()
+{
+  ::bypass_stats[this].print(NAME);
+  ::cat_partition.at(this).print();
+  ::owners.at(this).print(NAME);
+  ::presence.at(this).print();
+  ::writebacks.at(this).print(NAME);
+  ::breakdown.at(this).print();
+  ::reuse.at(this).print(NAME);
+  ::sampling.at(this).print(NAME);
+  ::top_pcs.at(this).print(NAME);
+#ifdef UCP_PARTITION
+  ::partition.at(this).print(NAME);
+#endif
+#ifdef DEAD_BLOCK_SCORING
+  ::scoring.at(this).print(NAME);
+#endif
+  ::training.at(this).drain();
+  ::training.at(this).print(NAME);
+}
@@ -1,29 +1,88 @@
+#include <algorithm>
 #include <cassert>
 
+#include "access_breakdown.h"
 #include "cache.h"
+#include "metadata_prefetch.h"
+#include "owner_tracker.h"
+#include "presence_hints.h"
+#include "replacement_batch.h"
+#include "reuse_profiler.h"
+#include "set_sampling.h"
+#include "way_mask.h"
+#include "way_partition.h"
+#include "writeback_policy.h"
 #include <unordered_map>
 
+#ifdef UCP_PARTITION
+#include "ucp.h"
+#endif
+
 namespace
 {
 constexpr int maxRRPV = 3;
 std::unordered_map<CACHE*, std::vector<int>> rrpv_values;
+std::unordered_map<CACHE*, champsim::way_partition> cat_partition;
+std::unordered_map<CACHE*, champsim::owner_tracker> owners;
+std::unordered_map<CACHE*, champsim::presence_hints> presence;
+std::unordered_map<CACHE*, champsim::writeback_policy> writebacks;
+std::unordered_map<CACHE*, champsim::access_breakdown> breakdown;
+std::unordered_map<CACHE*, champsim::reuse_profiler> reuse;
+std::unordered_map<CACHE*, champsim::set_sampling> sampling;
+
+#ifdef UCP_PARTITION
+std::unordered_map<CACHE*, champsim::ucp> partition;
+#endif
+
+// applies a batch of hits and fills, defined below and registered for each cache by initialize_replacement()
+void update_batch(CACHE* cache, const champsim::replacement_access* first, const champsim::replacement_access* last);
 } // namespace
 
 // initialize replacement state
-void CACHE::initialize_replacement() { ::rrpv_values[this] = std::vector<int>(NUM_SET * NUM_WAY, ::maxRRPV); }
+void CACHE::initialize_replacement()
+{
+  ::rrpv_values[this] = std::vector<int>(NUM_SET * NUM_WAY, ::maxRRPV);
+  ::cat_partition.try_emplace(this, NAME, NUM_WAY);
+  ::owners.emplace(this, champsim::owner_tracker{NUM_SET, NUM_WAY});
+  ::presence.try_emplace(this, NAME, NUM_SET, NUM_WAY);
+  ::writebacks.emplace(this, champsim::writeback_policy{NUM_SET, NUM_WAY});
+  ::breakdown.emplace(this, champsim::access_breakdown{NAME, NUM_SET, NUM_WAY});
+  ::reuse.emplace(this, champsim::reuse_profiler{NUM_SET});
+  ::sampling.emplace(this, champsim::set_sampling{NUM_SET, NUM_WAY});
+#ifdef UCP_PARTITION
+  ::partition.emplace(this, champsim::ucp{NUM_SET, NUM_WAY});
+#endif
+
+  // for callers that batch their updates (see replacement_batch.h)
+  champsim::replacement_batches()[NAME] = [this](const champsim::replacement_access* first, const champsim::replacement_access* last) {
+    ::update_batch(this, first, last);
+  };
+}
 
 // find replacement victim
 uint32_t CACHE::find_victim(uint32_t triggering_cpu, uint64_t instr_id, uint32_t set, const BLOCK* current_set, uint64_t ip, uint64_t full_addr, uint32_t type)
 {
+  if (!::sampling.at(this).modeled(set))
+    return ::sampling.at(this).skipped_victim(set);
+
+  auto candidates = ::cat_partition.at(this).victim_mask(triggering_cpu);
+#ifdef UCP_PARTITION
+  if (auto ucp_candidates = candidates & ::partition.at(this).victim_mask(triggering_cpu, set, ::owners.at(this)); ucp_candidates != 0)
+    candidates = ucp_candidates;
+#endif
+  candidates = ::presence.at(this).filter(set, candidates);
+  candidates = ::writebacks.at(this).filter(set, candidates);
+
   // look for the maxRRPV line
   auto begin = std::next(std::begin(::rrpv_values[this]), set * NUM_WAY);
   auto end = std::next(begin, NUM_WAY);
-  auto victim = std::find(begin, end, ::maxRRPV); // hijack the lru field
+  auto victim = champsim::masked_find(begin, end, candidates, ::maxRRPV); // hijack the lru field
   while (victim == end) {
+    // lines outside the candidates may already be at maxRRPV
     for (auto it = begin; it != end; ++it)
-      ++(*it);
+      *it = std::min(*it + 1, ::maxRRPV);
 
-    victim = std::find(begin, end, ::maxRRPV);
+    victim = champsim::masked_find(begin, end, candidates, ::maxRRPV);
   }
 
   assert(begin <= victim);
@@ -31,15 +90,79 @@ uint32_t CACHE::find_victim(uint32_t triggering_cpu, uint64_t instr_id, uint32_t
   return static_cast<uint32_t>(std::distance(begin, victim)); // cast protected by assertions
 }
 
+namespace
+{
+// called with runs of hits and fills to one set
+void update_batch(CACHE* cache, const champsim::replacement_access* first, const champsim::replacement_access* last)
+{
+  auto& rrpv_values = ::rrpv_values[cache];
+  auto& owners = ::owners.at(cache);
+  auto& presence = ::presence.at(cache);
+  auto& writebacks = ::writebacks.at(cache);
+  auto& breakdown = ::breakdown.at(cache);
+  auto& reuse = ::reuse.at(cache);
+  auto& sampling = ::sampling.at(cache);
+#ifdef UCP_PARTITION
+  auto& partition = ::partition.at(cache);
+#endif
+
+  auto prefetch_set = [&](uint32_t set) { champsim::prefetch_range(rrpv_values.data() + std::size_t{set} * cache->NUM_WAY, cache->NUM_WAY); };
+
+  champsim::for_each_set_run(first, last, prefetch_set, [&](const champsim::set_run& run) {
+    if (!sampling.modeled(run.set()))
+      return;
+
+    auto set_rrpv = rrpv_values.data() + std::size_t{run.set()} * cache->NUM_WAY;
+
+    for (const auto& [triggering_cpu, set, way, full_addr, ip, victim_addr, type, hit] : run) {
+      sampling.record(set, type, hit);
+#ifdef UCP_PARTITION
+      if (access_type{type} != access_type::WRITE)
+        partition.access(triggering_cpu, set, full_addr);
+#endif
+      if (!hit)
+        owners.miss(triggering_cpu, set, way, full_addr, victim_addr);
+      presence.update(set, way, full_addr, type, hit);
+      writebacks.update(set, way, type, hit);
+      breakdown.update(triggering_cpu, set, way, type, hit);
+      reuse.access(triggering_cpu, set, full_addr, type);
+
+      // the fill was bypassed, there is no line to update
+      if (way == cache->NUM_WAY)
+        continue;
+
+      auto& line_rrpv = set_rrpv[way];
+      if (writebacks.apply(type, hit, [&] { line_rrpv = ::maxRRPV; }, [&] { line_rrpv = 0; }))
+        continue;
+
+      if (hit)
+        line_rrpv = 0;
+      else
+        line_rrpv = ::maxRRPV - 1;
+    }
+  });
+}
+} // namespace
+
 // called on every cache hit and cache fill
 void CACHE::update_replacement_state(uint32_t triggering_cpu, uint32_t set, uint32_t way, uint64_t full_addr, uint64_t ip, uint64_t victim_addr, uint32_t type,
                                      uint8_t hit)
 {
-  if (hit)
-    ::rrpv_values[this][set * NUM_WAY + way] = 0;
-  else
-    ::rrpv_values[this][set * NUM_WAY + way] = ::maxRRPV - 1;
+  champsim::replacement_access access{triggering_cpu, set, way, full_addr, ip, victim_addr, type, hit};
+  ::update_batch(this, &access, &access + 1);
 }
 
 // use this function to print out your own stats at the end of simulation
-void CACHE::replacement_final_stats() {}
+void CACHE::replacement_final_stats()
+{
+  ::cat_partition.at(this).print();
+  ::owners.at(this).print(NAME);
+  ::presence.at(this).print();
+  ::writebacks.at(this).print(NAME);
+  ::breakdown.at(this).print();
+  ::reuse.at(this).print(NAME);
+  ::sampling.at(this).print(NAME);
+#ifdef UCP_PARTITION
+  ::partition.at(this).print(NAME);
+#endif
+}
@@ -0,0 +1,99 @@
+/*
+ * Summarize a DRRIP PSEL trace (see inc/psel_trace.h)
+ *
+ *   g++ -std=c++17 -O2 -pthread -Iinc tools/psel_trace_summary.cc -o psel_trace_summary
+ *   ./psel_trace_summary [-v] <trace file>
+ *
+ * For each core, prints the share of its misses and cycles spent following BIP and SRRIP, the number of policy switches
+ * and the shortest and mean run between them, and the mean sampled PSEL. The trace may be compressed with xz, gzip or
+ * zstd; -v also reports the throughput of the reading pipeline.
+ */
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+#include "async_trace_reader.h"
+#include "psel_trace.h"
+
+namespace
+{
+struct core_summary {
+  bool bip = false; // PSEL starts at zero, following SRRIP
+  uint64_t last_misses = 0;
+  uint64_t last_cycle = 0;
+  uint64_t last_switch = 0;
+  uint64_t misses[2] = {};
+  uint64_t cycles[2] = {};
+  uint64_t switches = 0;
+  uint64_t shortest_run = std::numeric_limits<uint64_t>::max();
+  uint64_t samples = 0;
+  uint64_t psel_sum = 0;
+};
+
+double share(const uint64_t (&x)[2], int i) { return x[0] + x[1] > 0 ? static_cast<double>(x[i]) / static_cast<double>(x[0] + x[1]) : 0.0; }
+} // namespace
+
+int main(int argc, char** argv)
+{
+  bool verbose = argc == 3 && std::strcmp(argv[1], "-v") == 0;
+  if (argc != 2 && !verbose) {
+    std::cerr << "usage: " << argv[0] << " [-v] <trace file>" << std::endl;
+    return 1;
+  }
+
+  const char* path = argv[argc - 1];
+  champsim::psel_trace_header header;
+  champsim::async_trace_reader<champsim::psel_trace_record> in{path, &header};
+  if (!in.good() || std::memcmp(header.magic, champsim::PSEL_TRACE_MAGIC, sizeof(header.magic)) != 0 || header.version != champsim::PSEL_TRACE_VERSION) {
+    std::cerr << path << ": not a version " << champsim::PSEL_TRACE_VERSION << " PSEL trace" << std::endl;
+    return 1;
+  }
+
+  std::vector<core_summary> cores(header.num_cpus);
+  champsim::psel_trace_record record;
+  uint64_t records = 0;
+  while (in.next(record)) {
+    ++records;
+    if (record.cpu >= cores.size()) {
+      std::cerr << path << ": record " << records << " has cpu " << record.cpu << ", beyond the " << header.num_cpus << " in the header" << std::endl;
+      return 1;
+    }
+
+    // the time since the core's previous record was spent under the policy it was following then
+    auto& core = cores[record.cpu];
+    core.misses[core.bip] += record.misses - core.last_misses;
+    core.cycles[core.bip] += record.cycle - std::min(core.last_cycle, record.cycle);
+    core.last_misses = record.misses;
+    core.last_cycle = record.cycle;
+
+    if (record.event == champsim::psel_event::sample) {
+      ++core.samples;
+      core.psel_sum += record.psel;
+      core.bip = record.psel > header.psel_max / 2;
+    } else {
+      ++core.switches;
+      core.shortest_run = std::min(core.shortest_run, record.misses - core.last_switch);
+      core.last_switch = record.misses;
+      core.bip = record.event == champsim::psel_event::to_bip;
+    }
+  }
+
+  std::cout << path << ": " << records << " records, " << header.num_cpus << " cores, PSEL sampled every " << header.sample_interval << " misses" << std::endl;
+  for (std::size_t cpu = 0; cpu < cores.size(); ++cpu) {
+    const auto& core = cores[cpu];
+    std::cout << "CPU " << cpu << " BIP: " << share(core.misses, 1) << " of misses, " << share(core.cycles, 1) << " of cycles";
+    std::cout << " SRRIP: " << share(core.misses, 0) << " of misses, " << share(core.cycles, 0) << " of cycles" << std::endl;
+    std::cout << "CPU " << cpu << " SWITCHES: " << core.switches;
+    if (core.switches > 0) {
+      std::cout << " SHORTEST RUN: " << core.shortest_run << " misses";
+      std::cout << " MEAN RUN: " << static_cast<double>(core.last_misses) / static_cast<double>(core.switches + 1) << " misses";
+    }
+    std::cout << " MEAN PSEL: " << (core.samples > 0 ? static_cast<double>(core.psel_sum) / static_cast<double>(core.samples) : 0.0) << std::endl;
+  }
+
+  if (verbose)
+    in.print("PSEL");
+}